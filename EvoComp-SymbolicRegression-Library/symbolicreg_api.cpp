@@ -0,0 +1,321 @@
+/*
+* symbolicreg_api.cpp
+* UIdaho CS-572: Evolutionary Computation
+* C interface - a stable, C-callable wrapper around Population and
+* Model for programs that embed the engine in-process
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "symbolicreg_api.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+#include "dataset.h"
+#include "model.h"
+#include "operator_set.h"
+#include "population.h"
+
+struct ecsr_population {
+	std::unique_ptr<Population> population;
+	size_t elitism_count;
+	size_t generation;
+};
+struct ecsr_model {
+	Model model;
+};
+
+/* The last failure on the calling thread, for ecsr_last_error() */
+static thread_local std::string last_error;
+
+static int Fail(const std::string &message);
+static int CheckConfig(const ecsr_config &config);
+static int CheckColumns(const double *const *columns, size_t count);
+
+int ecsr_version(void) {
+	return ECSR_API_VERSION;
+}
+const char* ecsr_last_error(void) {
+	return last_error.c_str();
+}
+void ecsr_default_config(ecsr_config *config) {
+	/* The same run as ec_symbolicreg.cpp, less its file handling */
+	if (!config) {
+		return;
+	}
+	config->population_size = 100;
+	config->mutation_rate = 0.03;
+	config->nonterminal_crossover_rate = 0.90;
+	config->tournament_size = 7;
+	config->depth_min = 3;
+	config->depth_max = 6;
+	config->tree_size_limit = 256;
+	config->tree_depth_limit = 17;
+	config->const_min = -10.0;
+	config->const_max = 10.0;
+	config->operators = "+ - * /";
+	config->seed = 0;
+	config->thread_count = 0;
+	config->numa_aware = 1; /* A no-op on one node */
+	config->elitism_count = 2;
+	config->constant_opt_count = 0;
+	config->constant_opt_iterations = 10;
+}
+ecsr_population* ecsr_create(const ecsr_config *config,
+							 const double *const *columns,
+							 const double *targets, size_t row_count,
+							 size_t input_count) {
+	/*
+	 * Builds the population over a view of the caller's columns, so no
+	 * data is copied unless numa_aware asks for per-node replicas.  The
+	 * initial population is evaluated before this returns.
+	 */
+	if (!config) {
+		Fail("No configuration given");
+		return nullptr;
+	}
+	if (CheckConfig(*config) != 0 ||
+		CheckColumns(columns, input_count) != 0) {
+		return nullptr;
+	}
+	if (!targets || row_count == 0) {
+		Fail("No target values given");
+		return nullptr;
+	}
+	try {
+		std::unique_ptr<ecsr_population> handle(new ecsr_population);
+		handle->population.reset(new Population(
+			config->population_size, config->mutation_rate,
+			config->nonterminal_crossover_rate, config->tournament_size,
+			config->depth_min, config->depth_max, config->const_min,
+			config->const_max, input_count - 1,
+			Dataset(columns, targets, row_count, input_count),
+			OperatorSet(config->operators), config->seed));
+		Population &p = *handle->population;
+		if (config->thread_count) {
+			p.SetThreadCount(config->thread_count);
+		}
+		p.SetInitialization(kRampedHalfAndHalf, 3, 40, false);
+		p.SetSimplifyMode(kSimplifyCopy);
+		p.SetRowTiling(4096);
+		p.SetStaticAnalysis(true);
+		p.SetNumaPolicy(config->numa_aware != 0);
+		p.SetDuplicateHandling(true, kDuplicatesAllowed, 0.5);
+		p.SetTreeLimits(config->tree_size_limit, config->tree_depth_limit);
+		p.SetConstantOptimization(config->constant_opt_count,
+								  config->constant_opt_iterations);
+		p.Initialize();
+		handle->elitism_count = config->elitism_count;
+		handle->generation = 0;
+		return handle.release();
+	} catch (const std::exception &e) {
+		Fail(e.what());
+		return nullptr;
+	}
+}
+void ecsr_destroy(ecsr_population *population) {
+	delete population;
+}
+int ecsr_evolve(ecsr_population *population, size_t generations) {
+	if (!population) {
+		return Fail("No population given");
+	}
+	try {
+		for (size_t i = 0; i < generations; ++i) {
+			population->population->Evolve(population->elitism_count);
+			++population->generation;
+		}
+		return 0;
+	} catch (const std::exception &e) {
+		return Fail(e.what());
+	}
+}
+int ecsr_get_stats(ecsr_population *population, ecsr_stats *stats) {
+	if (!population || !stats) {
+		return Fail("No population or stats given");
+	}
+	Population &p = *population->population;
+	stats->generation = population->generation;
+	stats->best_fitness = p.GetBestFitness();
+	stats->average_fitness = p.GetAverageFitness();
+	stats->worst_fitness = p.GetWorstFitness();
+	stats->largest_tree_size = p.GetLargestTreeSize();
+	stats->average_tree_size = p.GetAverageTreeSize();
+	stats->smallest_tree_size = p.GetSmallestTreeSize();
+	stats->semantic_diversity = p.GetSemanticDiversity();
+	stats->structural_diversity = p.GetStructuralDiversity();
+	return 0;
+}
+size_t ecsr_best_expression(ecsr_population *population, char *buffer,
+							size_t buffer_size) {
+	if (!population) {
+		Fail("No population given");
+		return 0;
+	}
+	try {
+		std::string text =
+			population->population->GetBestSolutionToString(false, false);
+		if (buffer && buffer_size) {
+			size_t n = std::min(text.size(), buffer_size - 1);
+			std::memcpy(buffer, text.data(), n);
+			buffer[n] = '\0';
+		}
+		return text.size();
+	} catch (const std::exception &e) {
+		Fail(e.what());
+		return 0;
+	}
+}
+int ecsr_save_best_model(ecsr_population *population,
+						 const char *filename) {
+	if (!population || !filename) {
+		return Fail("No population or filename given");
+	}
+	try {
+		if (!population->population->SaveBestModel(filename)) {
+			return Fail(std::string("Failed to save model: ") + filename);
+		}
+		return 0;
+	} catch (const std::exception &e) {
+		return Fail(e.what());
+	}
+}
+ecsr_model* ecsr_best_model(ecsr_population *population) {
+	if (!population) {
+		Fail("No population given");
+		return nullptr;
+	}
+	try {
+		std::unique_ptr<ecsr_model> handle(new ecsr_model);
+		if (!population->population->GetBestModel(handle->model)) {
+			Fail("Failed to build a model from the best individual");
+			return nullptr;
+		}
+		return handle.release();
+	} catch (const std::exception &e) {
+		Fail(e.what());
+		return nullptr;
+	}
+}
+ecsr_model* ecsr_model_load(const char *filename) {
+	if (!filename) {
+		Fail("No filename given");
+		return nullptr;
+	}
+	try {
+		std::unique_ptr<ecsr_model> handle(new ecsr_model);
+		if (!handle->model.Load(filename)) {
+			Fail(std::string("Failed to load model: ") + filename);
+			return nullptr;
+		}
+		return handle.release();
+	} catch (const std::exception &e) {
+		Fail(e.what());
+		return nullptr;
+	}
+}
+void ecsr_model_destroy(ecsr_model *model) {
+	delete model;
+}
+size_t ecsr_model_input_count(ecsr_model *model) {
+	return model ? model->model.GetColumnCount() : 0;
+}
+int ecsr_model_predict(ecsr_model *model, const double *const *columns,
+					   size_t row_count, double *out) {
+	if (!model || !out) {
+		return Fail("No model or output buffer given");
+	}
+	size_t input_count = model->model.GetColumnCount();
+	if (CheckColumns(columns, input_count) != 0) {
+		return -1;
+	}
+	try {
+		Dataset data(columns, nullptr, row_count, input_count);
+		model->model.Predict(data, 0, row_count, out);
+		return 0;
+	} catch (const std::exception &e) {
+		return Fail(e.what());
+	}
+}
+int ecsr_model_score(ecsr_model *model, const double *const *columns,
+					 const double *targets, size_t row_count, double *rmse) {
+	/* Root mean squared error, the same measure as a run's fitness */
+	if (!targets || !rmse || row_count == 0) {
+		return Fail("No targets or result given");
+	}
+	try {
+		std::vector<double> predictions(row_count);
+		if (ecsr_model_predict(model, columns, row_count,
+							   predictions.data()) != 0) {
+			return -1;
+		}
+		double sse = 0;
+		for (size_t i = 0; i < row_count; ++i) {
+			double error = predictions[i] - targets[i];
+			sse += error * error;
+		}
+		*rmse = std::sqrt(sse / row_count);
+		return 0;
+	} catch (const std::exception &e) {
+		return Fail(e.what());
+	}
+}
+
+/* Helper Functions */
+static int Fail(const std::string &message) {
+	/* Always -1, so a caller can fail and return in one statement */
+	last_error = message;
+	return -1;
+}
+static int CheckConfig(const ecsr_config &config) {
+	/* Everything Population would otherwise exit over, or misbehave on */
+	std::string error;
+	if (!config.operators ||
+		!OperatorSet::IsValid(config.operators, error)) {
+		return Fail(config.operators ? error : "No operators given");
+	}
+	if (config.population_size < 2 || config.tournament_size == 0) {
+		return Fail("Population and tournament sizes must be positive");
+	}
+	if (config.elitism_count >= config.population_size) {
+		return Fail("Elitism count must be below the population size");
+	}
+	if (!(config.const_min <= config.const_max)) {
+		return Fail("Constant range must satisfy minimum <= maximum");
+	}
+	if (!(config.mutation_rate >= 0 && config.mutation_rate <= 1) ||
+		!(config.nonterminal_crossover_rate >= 0 &&
+		  config.nonterminal_crossover_rate <= 1)) {
+		return Fail("Rates must lie in [0, 1]");
+	}
+	return 0;
+}
+static int CheckColumns(const double *const *columns, size_t count) {
+	if (!columns || count == 0) {
+		return Fail("No input columns given");
+	}
+	for (size_t i = 0; i < count; ++i) {
+		if (!columns[i]) {
+			return Fail("Input column " + std::to_string(i) + " is null");
+		}
+	}
+	return 0;
+}
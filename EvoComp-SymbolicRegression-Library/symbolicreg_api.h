@@ -0,0 +1,126 @@
+/*
+* symbolicreg_api.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for the C interface - a stable, C-callable wrapper around
+* Population and Model for programs that embed the engine in-process
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+/*
+ * Everything here is plain C so the library can be loaded from any
+ * language with a C FFI.  Objects are opaque handles; functions that can
+ * fail return NULL or nonzero and leave a message for ecsr_last_error().
+ * Bad arguments are reported this way instead of exiting the process.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(ECSR_BUILD_DLL)
+#define ECSR_API __declspec(dllexport)
+#else
+#define ECSR_API __declspec(dllimport)
+#endif
+#else
+#define ECSR_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Raised whenever a declaration below changes incompatibly */
+#define ECSR_API_VERSION 1
+
+typedef struct ecsr_population ecsr_population;
+typedef struct ecsr_model ecsr_model;
+
+/* Run settings; fill with ecsr_default_config() before changing any */
+typedef struct ecsr_config {
+	size_t population_size;
+	double mutation_rate;
+	double nonterminal_crossover_rate;
+	size_t tournament_size;
+	size_t depth_min;
+	size_t depth_max;
+	size_t tree_size_limit; /* Enforced during crossover; 0 = none */
+	size_t tree_depth_limit;
+	double const_min;
+	double const_max;
+	const char *operators; /* e.g. "+ - * / sin"; copied at create */
+	uint32_t seed; /* 0 = random; otherwise replayable */
+	size_t thread_count; /* 0 = one per hardware thread */
+	int numa_aware; /* Nonzero copies the data to each NUMA node */
+	size_t elitism_count;
+	size_t constant_opt_count; /* Best few to tune, 0 (default) for none */
+	size_t constant_opt_iterations;
+} ecsr_config;
+
+typedef struct ecsr_stats {
+	size_t generation;
+	double best_fitness;
+	double average_fitness;
+	double worst_fitness;
+	size_t largest_tree_size;
+	size_t average_tree_size;
+	size_t smallest_tree_size;
+	double semantic_diversity;
+	double structural_diversity;
+} ecsr_stats;
+
+ECSR_API int ecsr_version(void);
+ECSR_API const char *ecsr_last_error(void);
+ECSR_API void ecsr_default_config(ecsr_config *config);
+
+/*
+ * columns holds input_count pointers to row_count doubles each, targets
+ * row_count more.  The buffers are read in place, never copied, so they
+ * must stay alive and unchanged until ecsr_destroy().
+ */
+ECSR_API ecsr_population *ecsr_create(const ecsr_config *config,
+									  const double *const *columns,
+									  const double *targets,
+									  size_t row_count, size_t input_count);
+ECSR_API void ecsr_destroy(ecsr_population *population);
+ECSR_API int ecsr_evolve(ecsr_population *population, size_t generations);
+ECSR_API int ecsr_get_stats(ecsr_population *population, ecsr_stats *stats);
+
+/* Returns the length needed, like snprintf; buffer may be NULL */
+ECSR_API size_t ecsr_best_expression(ecsr_population *population,
+									 char *buffer, size_t buffer_size);
+ECSR_API int ecsr_save_best_model(ecsr_population *population,
+								  const char *filename);
+
+/* A model outlives the population it came from */
+ECSR_API ecsr_model *ecsr_best_model(ecsr_population *population);
+ECSR_API ecsr_model *ecsr_model_load(const char *filename);
+ECSR_API void ecsr_model_destroy(ecsr_model *model);
+ECSR_API size_t ecsr_model_input_count(ecsr_model *model);
+/* columns holds ecsr_model_input_count() pointers, as for ecsr_create */
+ECSR_API int ecsr_model_predict(ecsr_model *model,
+								const double *const *columns,
+								size_t row_count, double *out);
+ECSR_API int ecsr_model_score(ecsr_model *model,
+							  const double *const *columns,
+							  const double *targets, size_t row_count,
+							  double *rmse);
+
+#ifdef __cplusplus
+}
+#endif
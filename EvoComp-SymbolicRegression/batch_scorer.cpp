@@ -0,0 +1,235 @@
+/*
+* batch_scorer.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Implementation of BatchScorer class - streams a large input file
+* through a saved Model in fixed-size chunks and writes one prediction
+* per row
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "batch_scorer.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include "number_format.h"
+
+static const char kColumnarMagic[8] = { 'E','C','S','R','C','O','L','1' };
+static const size_t kTaskRows = 4096; /* Rows per thread pool task */
+
+BatchScorer::BatchScorer(Model &model, ThreadPool &pool, size_t chunk_rows)
+	: model_(model), pool_(pool), row_count_(0), bad_cells_(0) {
+	chunk_rows_ = chunk_rows ? chunk_rows : 1;
+}
+bool BatchScorer::Score(const std::string &input, const std::string &output) {
+	/* Picks the reader by the columnar magic number */
+	char magic[sizeof(kColumnarMagic)] = {};
+	std::ifstream inf(input, std::ifstream::in | std::ifstream::binary);
+	if (!inf) {
+		std::cerr << "Failed to open file: " << input << std::endl;
+		return false;
+	}
+	inf.read(magic, sizeof(magic));
+	inf.close();
+	if (std::memcmp(magic, kColumnarMagic, sizeof(magic)) == 0) {
+		return ScoreColumnar(input, output);
+	}
+	return ScoreCsv(input, output);
+}
+bool BatchScorer::ScoreCsv(const std::string &input,
+						   const std::string &output) {
+	std::ifstream inf(input, std::ifstream::in);
+	std::string line;
+	size_t columns = model_.GetColumnCount();
+	if (!inf) {
+		std::cerr << "Failed to open file: " << input << std::endl;
+		return false;
+	}
+
+	/* The header says how many columns there are; a target is skipped */
+	std::getline(inf, line);
+	size_t file_columns = std::count(line.begin(), line.end(), ',') + 1;
+	if (file_columns != columns && file_columns != columns + 1) {
+		std::cerr << "Expected " << columns << " input columns in "
+				  << input << std::endl;
+		return false;
+	}
+	if (!OpenOutput(output)) {
+		return false;
+	}
+
+	row_count_ = 0;
+	bad_cells_ = 0;
+	lines_.resize(chunk_rows_);
+	while (inf) {
+		size_t count = 0;
+		while (count < chunk_rows_ && std::getline(inf, lines_[count])) {
+			if (!lines_[count].empty()) {
+				++count;
+			}
+		}
+		if (!count) {
+			break;
+		}
+
+		chunk_.Resize(count, columns);
+		std::atomic<size_t> bad_cells(0);
+		size_t tasks = (count + kTaskRows - 1) / kTaskRows;
+		pool_.ParallelFor(tasks, [&](size_t task) {
+			size_t end = std::min(count, (task + 1) * kTaskRows);
+			size_t bad = 0;
+			for (size_t row = task * kTaskRows; row < end; ++row) {
+				const char *cur = lines_[row].c_str();
+				for (size_t col = 0; col < columns; ++col) {
+					char *stop = nullptr;
+					double value = std::strtod(cur, &stop);
+					if (stop == cur) {
+						value = std::numeric_limits<double>::quiet_NaN();
+						++bad;
+					}
+					chunk_.GetMutableColumn(col)[row] = value;
+					cur = std::strchr(stop, ',');
+					cur = cur ? cur + 1 : stop;
+				}
+			}
+			bad_cells += bad;
+		});
+		bad_cells_ += bad_cells;
+		ScoreChunk();
+	}
+	outf_.close();
+	if (bad_cells_) {
+		std::cerr << bad_cells_ << " cells of " << input
+				  << " were not numbers and were read as NaN" << std::endl;
+	}
+	return true;
+}
+bool BatchScorer::ScoreColumnar(const std::string &input,
+								const std::string &output) {
+	std::ifstream inf(input, std::ifstream::in | std::ifstream::binary);
+	char magic[sizeof(kColumnarMagic)];
+	uint64_t rows = 0;
+	uint64_t file_columns = 0;
+	size_t columns = model_.GetColumnCount();
+	if (!inf) {
+		std::cerr << "Failed to open file: " << input << std::endl;
+		return false;
+	}
+	inf.read(magic, sizeof(magic));
+	inf.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+	inf.read(reinterpret_cast<char*>(&file_columns), sizeof(file_columns));
+	if (!inf || std::memcmp(magic, kColumnarMagic, sizeof(magic)) != 0 ||
+		file_columns < columns) {
+		std::cerr << "Not a columnar file with " << columns
+				  << " columns: " << input << std::endl;
+		return false;
+	}
+	if (!OpenOutput(output)) {
+		return false;
+	}
+
+	/* Each chunk reads its slice of every column the model uses */
+	const std::streamoff kDataStart = sizeof(magic) + 2 * sizeof(uint64_t);
+	row_count_ = 0;
+	bad_cells_ = 0;
+	for (uint64_t begin = 0; begin < rows; begin += chunk_rows_) {
+		size_t count = static_cast<size_t>(
+			std::min<uint64_t>(chunk_rows_, rows - begin));
+		chunk_.Resize(count, columns);
+		for (size_t col = 0; col < columns; ++col) {
+			inf.seekg(kDataStart + static_cast<std::streamoff>(
+				(col * rows + begin) * sizeof(double)));
+			inf.read(reinterpret_cast<char*>(chunk_.GetMutableColumn(col)),
+					 count * sizeof(double));
+		}
+		if (!inf) {
+			std::cerr << "Unexpected end of file: " << input << std::endl;
+			outf_.close();
+			return false;
+		}
+		ScoreChunk();
+	}
+	outf_.close();
+	return true;
+}
+bool BatchScorer::WriteColumnar(const std::string &filename,
+								const Dataset &data) {
+	/* Writes the input columns of data in the layout ScoreColumnar reads */
+	std::ofstream outf(filename, std::ofstream::out | std::ofstream::binary |
+					   std::ofstream::trunc);
+	uint64_t rows = data.GetRowCount();
+	uint64_t columns = data.GetColumnCount();
+	if (!outf) {
+		std::cerr << "Failed to open file: " << filename << std::endl;
+		return false;
+	}
+	outf.write(kColumnarMagic, sizeof(kColumnarMagic));
+	outf.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+	outf.write(reinterpret_cast<const char*>(&columns), sizeof(columns));
+	for (size_t col = 0; col < columns; ++col) {
+		outf.write(reinterpret_cast<const char*>(data.GetColumn<double>(col)),
+				   rows * sizeof(double));
+	}
+	return static_cast<bool>(outf);
+}
+
+/* Private Accessors/Mutators */
+size_t BatchScorer::GetRowCount() {
+	return row_count_;
+}
+size_t BatchScorer::GetBadCellCount() {
+	return bad_cells_;
+}
+bool BatchScorer::OpenOutput(const std::string &output) {
+	outf_.close();
+	outf_.clear();
+	outf_.open(output, std::ofstream::out | std::ofstream::trunc);
+	if (!outf_) {
+		std::cerr << "Failed to open file: " << output << std::endl;
+		return false;
+	}
+	outf_ << "prediction\n";
+	return true;
+}
+void BatchScorer::ScoreChunk() {
+	/* Predicts and formats chunk_ in parallel, then appends it in order */
+	size_t count = chunk_.GetRowCount();
+	size_t tasks = (count + kTaskRows - 1) / kTaskRows;
+	predictions_.resize(count);
+	text_.resize(tasks);
+	pool_.ParallelFor(tasks, [&](size_t task) {
+		size_t begin = task * kTaskRows;
+		size_t rows = std::min(count - begin, kTaskRows);
+		model_.Predict(chunk_, begin, rows, predictions_.data() + begin);
+
+		std::string &text = text_[task];
+		text.clear();
+		for (size_t i = begin; i < begin + rows; ++i) {
+			AppendDouble(text, predictions_[i]);
+			text.push_back('\n');
+		}
+	});
+	for (size_t task = 0; task < tasks; ++task) {
+		outf_ << text_[task];
+	}
+	row_count_ += count;
+}
@@ -0,0 +1,77 @@
+/*
+* batch_scorer.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for BatchScorer class - streams a large input file through a
+* saved Model in fixed-size chunks and writes one prediction per row
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "dataset.h"
+#include "model.h"
+#include "thread_pool.h"
+
+/*
+ * Inputs are either CSV, laid out like the training data (a header line,
+ * then one row per line, with an optional trailing target column that is
+ * ignored), or binary columnar:
+ *
+ *   char[8]  "ECSRCOL1"
+ *   uint64   row count
+ *   uint64   column count
+ *   double   column 0 rows, then column 1 rows, ... (native byte order)
+ *
+ * Only chunk_rows rows are held at a time, whatever the input size.
+ * Parsing, evaluation and formatting of a chunk are spread over the
+ * thread pool; reading and writing stay on the calling thread.
+ */
+class BatchScorer {
+public:
+	BatchScorer(Model &model, ThreadPool &pool, size_t chunk_rows = 65536);
+
+	bool Score(const std::string &input, const std::string &output);
+	bool ScoreCsv(const std::string &input, const std::string &output);
+	bool ScoreColumnar(const std::string &input, const std::string &output);
+	static bool WriteColumnar(const std::string &filename,
+							  const Dataset &data);
+
+	/* Private Accessors/Mutators */
+	size_t GetRowCount();
+	size_t GetBadCellCount();
+private:
+	bool OpenOutput(const std::string &output);
+	void ScoreChunk();
+
+	Model &model_;
+	ThreadPool &pool_;
+	size_t chunk_rows_;
+	size_t row_count_;
+	size_t bad_cells_; /* CSV cells that were not numbers; read as NaN */
+	std::ofstream outf_;
+
+	/* Reused for every chunk */
+	Dataset chunk_;
+	std::vector<std::string> lines_;
+	std::vector<double> predictions_;
+	std::vector<std::string> text_;
+};
@@ -0,0 +1,57 @@
+/*
+* case_error_matrix.cpp
+* UIdaho CS-572: Evolutionary Computation
+* CaseErrorMatrix - per-case absolute errors of a population
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "case_error_matrix.h"
+#include <limits>
+
+CaseErrorMatrix::CaseErrorMatrix() {
+	individual_count_ = 0;
+	case_count_ = 0;
+}
+void CaseErrorMatrix::Resize(size_t individual_count, size_t case_count) {
+	if (individual_count == individual_count_ && case_count == case_count_) {
+		return;
+	}
+	individual_count_ = individual_count;
+	case_count_ = case_count;
+
+	/* Padding at the end of the last block is never a survivor */
+	errors_.assign(GetBlockCount() * kBlockSize * case_count_,
+				   std::numeric_limits<float>::infinity());
+}
+float* CaseErrorMatrix::GetIndividual(size_t individual) {
+	size_t block = individual / kBlockSize;
+	return &errors_[block * kBlockSize * case_count_ + individual % kBlockSize];
+}
+const float* CaseErrorMatrix::GetBlock(size_t block,
+									   size_t case_index) const {
+	return &errors_[(block * case_count_ + case_index) * kBlockSize];
+}
+size_t CaseErrorMatrix::GetIndividualCount() const {
+	return individual_count_;
+}
+size_t CaseErrorMatrix::GetCaseCount() const {
+	return case_count_;
+}
+size_t CaseErrorMatrix::GetBlockCount() const {
+	return (individual_count_ + kBlockSize - 1) / kBlockSize;
+}
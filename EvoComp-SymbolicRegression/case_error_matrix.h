@@ -0,0 +1,53 @@
+/*
+* case_error_matrix.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for CaseErrorMatrix - per-case absolute errors of a population
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Absolute error of every individual on every fitness case, stored as
+ * float.  Individuals are grouped into blocks of kBlockSize; inside a
+ * block the errors are case-major, so the errors of one block on one case
+ * are contiguous and line up with one 64-bit word of a survivor bitset.
+ */
+class CaseErrorMatrix {
+public:
+	static const size_t kBlockSize = 64;
+
+	CaseErrorMatrix();
+
+	void Resize(size_t individual_count, size_t case_count);
+
+	/* Errors of one individual; consecutive cases are kBlockSize apart */
+	float* GetIndividual(size_t individual);
+	const float* GetBlock(size_t block, size_t case_index) const;
+
+	size_t GetIndividualCount() const;
+	size_t GetCaseCount() const;
+	size_t GetBlockCount() const;
+private:
+	std::vector<float> errors_;
+	size_t individual_count_;
+	size_t case_count_;
+};
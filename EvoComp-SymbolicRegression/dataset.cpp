@@ -0,0 +1,169 @@
+/*
+* dataset.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Implementation of Dataset class - the training data stored column by
+* column so a block of rows can be evaluated one operator at a time
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dataset.h"
+#include <algorithm>
+#include <utility> /* std::move */
+
+Dataset::Dataset()
+	: target_data_(nullptr), view_(false), row_count_(0), column_count_(0) {}
+Dataset::Dataset(const std::vector<SolutionData> &solutions) : view_(false) {
+	row_count_ = solutions.size();
+	column_count_ = solutions.empty() ? 0 : solutions[0].x.size();
+	columns_.resize(row_count_ * column_count_);
+	targets_.resize(row_count_);
+
+	for (size_t row = 0; row < row_count_; ++row) {
+		const std::vector<double> &x = solutions[row].x;
+		for (size_t col = 0; col < column_count_ && col < x.size(); ++col) {
+			columns_[col * row_count_ + row] = x[col];
+		}
+		targets_[row] = solutions[row].y;
+	}
+	PointAtStorage();
+}
+Dataset::Dataset(const double *const *columns, const double *targets,
+				 size_t row_count, size_t column_count)
+	: column_data_(columns, columns + column_count), target_data_(targets),
+	  view_(true), row_count_(row_count), column_count_(column_count) {}
+Dataset::Dataset(const Dataset &other) : Dataset() {
+	*this = other;
+}
+Dataset::Dataset(Dataset &&other) : Dataset() {
+	*this = std::move(other);
+}
+Dataset& Dataset::operator=(const Dataset &other) {
+	if (this == &other) {
+		return *this;
+	}
+	columns_ = other.columns_;
+	float_columns_ = other.float_columns_;
+	targets_ = other.targets_;
+	column_data_ = other.column_data_;
+	target_data_ = other.target_data_;
+	view_ = other.view_;
+	row_count_ = other.row_count_;
+	column_count_ = other.column_count_;
+	if (!view_) {
+		PointAtStorage();
+	}
+	return *this;
+}
+Dataset& Dataset::operator=(Dataset &&other) {
+	if (this == &other) {
+		return *this;
+	}
+	columns_ = std::move(other.columns_);
+	float_columns_ = std::move(other.float_columns_);
+	targets_ = std::move(other.targets_);
+	column_data_ = std::move(other.column_data_);
+	target_data_ = other.target_data_;
+	view_ = other.view_;
+	row_count_ = other.row_count_;
+	column_count_ = other.column_count_;
+	if (!view_) {
+		PointAtStorage();
+	}
+	other.Resize(0, 0);
+	return *this;
+}
+
+void Dataset::Assign(const Dataset &other) {
+	/*
+	 * Makes this an owned copy of other, view or not.  The copy's pages
+	 * are first touched by the calling thread, which is what a per-node
+	 * replica relies on.
+	 */
+	if (this == &other && !view_) {
+		return;
+	}
+	std::vector<const double*> from = other.column_data_;
+	const double *targets = other.target_data_;
+	std::vector<float> float_columns = other.float_columns_;
+	Resize(other.row_count_, other.column_count_);
+	for (size_t col = 0; col < column_count_; ++col) {
+		std::copy(from[col], from[col] + row_count_, GetMutableColumn(col));
+	}
+	std::copy(targets, targets + row_count_, targets_.begin());
+	float_columns_.swap(float_columns);
+}
+void Dataset::Resize(size_t row_count, size_t column_count) {
+	/*
+	 * Reshapes to row_count by column_count for filling column by column
+	 * through GetMutableColumn.  Storage is reused when it is big enough;
+	 * targets are zeroed and any float copy is dropped.  A view becomes
+	 * an owned dataset.
+	 */
+	row_count_ = row_count;
+	column_count_ = column_count;
+	view_ = false;
+	columns_.resize(row_count * column_count);
+	targets_.assign(row_count, 0);
+	float_columns_.clear();
+	PointAtStorage();
+}
+void Dataset::BuildSinglePrecision() {
+	/* A float copy of the inputs; targets stay double for the error sum */
+	float_columns_.resize(row_count_ * column_count_);
+	for (size_t col = 0; col < column_count_; ++col) {
+		for (size_t row = 0; row < row_count_; ++row) {
+			float_columns_[col * row_count_ + row] =
+				static_cast<float>(column_data_[col][row]);
+		}
+	}
+}
+
+/* Private Accessors/Mutators */
+template <> const double* Dataset::GetColumn<double>(size_t var_index) const {
+	return column_data_[var_index];
+}
+template <> const float* Dataset::GetColumn<float>(size_t var_index) const {
+	return float_columns_.data() + var_index * row_count_;
+}
+double* Dataset::GetMutableColumn(size_t var_index) {
+	return columns_.data() + var_index * row_count_;
+}
+const double* Dataset::GetTargets() const {
+	return target_data_;
+}
+size_t Dataset::GetRowCount() const {
+	return row_count_;
+}
+size_t Dataset::GetColumnCount() const {
+	return column_count_;
+}
+bool Dataset::HasSinglePrecision() const {
+	return !float_columns_.empty() || row_count_ * column_count_ == 0;
+}
+bool Dataset::IsView() const {
+	return view_;
+}
+
+/* Private Helper Functions */
+void Dataset::PointAtStorage() {
+	column_data_.resize(column_count_);
+	for (size_t col = 0; col < column_count_; ++col) {
+		column_data_[col] = columns_.data() + col * row_count_;
+	}
+	target_data_ = targets_.data();
+}
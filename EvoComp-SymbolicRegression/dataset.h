@@ -0,0 +1,76 @@
+/*
+* dataset.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for Dataset class - the training data stored column by column
+* so a block of rows can be evaluated one operator at a time
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "solution_data.h"
+
+/* Precision the trees are evaluated in; errors always add up in double */
+enum Precision {
+	kDoublePrecision = 1,
+	kSinglePrecision = 2
+};
+
+/*
+ * Column-major training data.  A Dataset either owns its columns or is
+ * a view of columns the caller keeps alive and unchanged for as long as
+ * the view (or any copy of it) is used.  Copying a view copies only the
+ * pointers; Assign always makes an owned copy.
+ */
+class Dataset {
+public:
+	Dataset();
+	explicit Dataset(const std::vector<SolutionData> &solutions);
+	Dataset(const double *const *columns, const double *targets,
+			size_t row_count, size_t column_count);
+	Dataset(const Dataset &other);
+	Dataset(Dataset &&other);
+	Dataset& operator=(const Dataset &other);
+	Dataset& operator=(Dataset &&other);
+
+	void Assign(const Dataset &other);
+	void Resize(size_t row_count, size_t column_count);
+	void BuildSinglePrecision();
+
+	/* Private Accessors/Mutators */
+	template <typename T> const T* GetColumn(size_t var_index) const;
+	double* GetMutableColumn(size_t var_index);
+	const double* GetTargets() const;
+	size_t GetRowCount() const;
+	size_t GetColumnCount() const;
+	bool HasSinglePrecision() const;
+	bool IsView() const;
+private:
+	void PointAtStorage();
+
+	std::vector<double> columns_; /* Column-major, row_count_ per column */
+	std::vector<float> float_columns_; /* Same layout; empty until built */
+	std::vector<double> targets_;
+	std::vector<const double*> column_data_; /* Into columns_ unless a view */
+	const double *target_data_;
+	bool view_;
+	size_t row_count_;
+	size_t column_count_;
+};
@@ -21,54 +21,254 @@
 * along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
+#include "batch_scorer.h"
+#include "evaluator_check.h"
+#include "generation_stats.h"
+#include "model.h"
+#include "operator_set.h"
 #include "population.h"
+#include "replay_trace.h"
+#include "run_logger.h"
 #include "solution_data.h"
 
 std::vector<SolutionData> ParseInput(std::string filename);
-std::string GetOutputDataString(size_t evolution_count, Population &p);
+void GetGenerationStats(size_t evolution_count, Population &p,
+						bool render_best, GenerationStats &stats);
+int ScoreMain(int argc, char *argv[]);
+int VerifyMain(int argc, char *argv[]);
+int CheckTraceMain(int argc, char *argv[]);
+
+int main(int argc, char *argv[]) {
+	/* "--score model input output" scores new data instead of evolving */
+	if (argc > 1 && std::string(argv[1]) == "--score") {
+		return ScoreMain(argc, argv);
+	}
+	/* "--verify input [tolerance]" checks the evaluators and exits */
+	if (argc > 1 && std::string(argv[1]) == "--verify") {
+		return VerifyMain(argc, argv);
+	}
+	/* "--check-trace golden trace" compares two replay traces */
+	if (argc > 1 && std::string(argv[1]) == "--check-trace") {
+		return CheckTraceMain(argc, argv);
+	}
 
-int main() {
 	/* Genetic Program Constants */
 	const std::string kInputFilename = "GPProjectData.csv";
 	const std::string kOutputFilename = "GPOutput_Run9_LaTeX_TS7.csv";
+	const std::string kModelFilename = "GPModel_Run9.txt";
+	const std::string kParetoFilename = "GPPareto_Run9.csv";
+	const std::string kTraceFilename = "GPTrace_Run9.csv";
+	const uint32_t kReplaySeed = 0; /* 0 = random; otherwise replayable */
 	const size_t kEvolutionCount = 1000;
 	const size_t kElitismCount = 2;
+	const bool kSteadyState = false; /* Replace losers in place instead */
+	const size_t kSteadyStateBatch = 10; /* Children bred per step */
+	const bool kAsyncEvaluation = false; /* Steady state, no step barrier */
+	const size_t kAsyncInFlight = 0; /* Children queued; 0 = 2 per thread */
+	const bool kAsyncSizePriority = true; /* Largest trees start first */
+	const bool kParetoEvolution = false; /* NSGA-II on fitness and size */
 
 	/* Population Constants */
 	const size_t kPopulationSize = 100;
 	const double kMutationRate = 0.03;
 	const double kNonTerminalCrossoverRate = 0.90; /* 90/10 Rule */
 	const size_t kTournamentSize = 7;
+	const SelectionType kSelectionType = kTournamentSelection;
+	const size_t kConstantOptCount = 0; /* Best few to tune, 0 for none */
+	const size_t kConstantOptIterations = 10;
+	const SimplifyMode kSimplifyMode = kSimplifyCopy;
+	const Precision kPrecision = kDoublePrecision; /* Or kSinglePrecision */
+	const size_t kRescoreCount = 4; /* Re-scored in double if single */
+	const size_t kRowTileRows = 4096; /* Rows per evaluation tile */
+	const bool kStaticAnalysis = true; /* Score constant/non-finite trees */
+	const size_t kSubtreeCacheBytes = 0; /* e.g. 256 << 20 for deep trees */
+	const bool kNumaAware = true; /* Per-node data; no-op on one node */
+	const bool kShareDuplicateFitness = true; /* Skip identical trees */
+	const DuplicatePolicy kDuplicatePolicy = kDuplicatesAllowed;
+	const double kDuplicatePenalty = 0.5; /* Only if kDuplicatesPenalized */
 
 	/* Individual/Node Constants */
 	const size_t kTreeDepthMin = 3;
 	const size_t kTreeDepthMax = 6;
+	const InitializationType kInitializationType = kRampedHalfAndHalf;
+	const size_t kInitSizeMin = 3; /* PTC2 target sizes */
+	const size_t kInitSizeMax = 40;
+	const bool kUniqueInit = false; /* Rebuild semantic duplicates */
+	const size_t kTreeSizeLimit = 256; /* Enforced during crossover */
+	const size_t kTreeDepthLimit = 17;
 	const double kConstMin = -10.0f;
 	const double kConstMax = 10.0f;
+	/* Any of + - * / sin cos exp log sqrt sq, separated by spaces */
+	const std::string kOperators = "+ - * /";
 	
 	/* File Parsing */
-	std::vector<SolutionData> solutions(ParseInput(kInputFilename));
-	size_t var_count = solutions[0].x.size() - 1;
+	/* Only the column copy outlives parsing; the rows are freed here */
+	Dataset data(ParseInput(kInputFilename));
+	size_t var_count = data.GetColumnCount() - 1;
 	Population p(kPopulationSize, kMutationRate, kNonTerminalCrossoverRate,
 				 kTournamentSize, kTreeDepthMin, kTreeDepthMax,
-				 kConstMin, kConstMax, var_count, solutions);
+				 kConstMin, kConstMax, var_count, std::move(data),
+				 OperatorSet(kOperators), kReplaySeed);
+	p.SetInitialization(kInitializationType, kInitSizeMin, kInitSizeMax,
+						kUniqueInit);
+	p.SetSimplifyMode(kSimplifyMode);
+	p.SetPrecision(kPrecision, kRescoreCount);
+	p.SetRowTiling(kRowTileRows);
+	p.SetStaticAnalysis(kStaticAnalysis);
+	p.SetSubtreeCache(kSubtreeCacheBytes);
+	p.SetNumaPolicy(kNumaAware);
+	p.SetDuplicateHandling(kShareDuplicateFitness, kDuplicatePolicy,
+						   kDuplicatePenalty);
+	p.SetTreeLimits(kTreeSizeLimit, kTreeDepthLimit);
+	p.SetSelectionType(kSelectionType);
+	p.SetConstantOptimization(kConstantOptCount, kConstantOptIterations);
+	p.SetAsyncEvaluation(kAsyncInFlight, kAsyncSizePriority);
 
-	/* Output File */
-	std::ofstream output_file;
-	output_file.open(kOutputFilename, std::ios::out | std::ios::trunc);
+	/* Output File, written on the logger's own thread */
+	RunLogger logger(kOutputFilename);
+	ReplayTrace trace;
+	if (!trace.Open(kTraceFilename)) {
+		exit(EXIT_FAILURE);
+	}
+	std::clog << "Seed: " << p.GetSeed() << std::endl;
+	std::clog << "NUMA nodes in use: " << p.GetNumaNodeCount() << std::endl;
 
 	/* Genetic Program Work */
+	GenerationStats stats;
+	uint64_t last_best_hash = 0;
+	size_t simplified_nodes = 0;
+	size_t evaluated_nodes = 0;
+	size_t skipped_evaluations = 0;
+	size_t reused_evaluations = 0;
+	size_t static_scores = 0;
 	for (size_t i = 0; i < kEvolutionCount; ++i) {
-		p.Evolve(kElitismCount);
-		output_file << GetOutputDataString(i + 1, p) << "\n";
+		if (kParetoEvolution) {
+			p.EvolvePareto();
+			simplified_nodes += p.GetSimplifiedNodeCount();
+		} else if (kAsyncEvaluation) {
+			p.EvolveAsync(kPopulationSize);
+			simplified_nodes += p.GetSimplifiedNodeCount();
+		} else if (kSteadyState) {
+			/* A generation's worth of replacements per log line */
+			for (size_t r = 0; r < kPopulationSize; r += kSteadyStateBatch) {
+				p.EvolveSteadyState(kSteadyStateBatch);
+				simplified_nodes += p.GetSimplifiedNodeCount();
+			}
+		} else {
+			p.Evolve(kElitismCount);
+			simplified_nodes += p.GetSimplifiedNodeCount();
+		}
+		evaluated_nodes += p.GetTotalNodeCount();
+		skipped_evaluations += p.GetSkippedEvaluationCount();
+		reused_evaluations += p.GetReusedEvaluationCount();
+		static_scores += p.GetStaticScoreCount();
+
+		/* Only render the best solution when it has actually changed */
+		uint64_t best_hash = p.GetBestSolutionHash();
+		GetGenerationStats(i + 1, p, (i == 0 || best_hash != last_best_hash),
+						   stats);
+		last_best_hash = best_hash;
+		trace.Record(stats, best_hash);
+		logger.Push(std::move(stats));
+	}
+	logger.Close();
+	trace.Close();
+	if (!p.SaveBestModel(kModelFilename)) {
+		exit(EXIT_FAILURE);
+	}
+	if (kParetoEvolution && !p.SaveParetoFront(kParetoFilename)) {
+		exit(EXIT_FAILURE);
 	}
-	output_file.close();
 	std::clog << "Best fitness: " << p.GetBestFitness() << std::endl;
+	std::clog << "Population memory: " << p.GetMemoryUsage() << " bytes, "
+			  << p.GetMemoryUsage() / kPopulationSize << " per individual"
+			  << std::endl;
+	if (kSimplifyMode != kSimplifyOff) {
+		std::clog << "Nodes removed by simplification: " << simplified_nodes
+				  << " of " << evaluated_nodes << std::endl;
+	}
+	if (kShareDuplicateFitness) {
+		std::clog << "Evaluations skipped as identical trees: "
+				  << skipped_evaluations << std::endl;
+	}
+	std::clog << "Evaluations reused from unchanged individuals: "
+			  << reused_evaluations << std::endl;
+	if (kStaticAnalysis) {
+		std::clog << "Evaluations settled by interval analysis: "
+				  << static_scores << std::endl;
+	}
+	if (kSubtreeCacheBytes) {
+		std::clog << "Subtree cache: " << p.GetSubtreeCacheUsage()
+				  << " bytes, " << p.GetSubtreeCacheHitRate() * 100
+				  << "% of lookups hit" << std::endl;
+	}
+	return 0;
+}
+int ScoreMain(int argc, char *argv[]) {
+	/* Rows per chunk; memory use is bounded by this, not the input size */
+	const size_t kScoreChunkRows = 65536;
+
+	if (argc != 5) {
+		std::cerr << "Usage: " << argv[0]
+				  << " --score <model file> <input file> <output file>"
+				  << std::endl;
+		return EXIT_FAILURE;
+	}
+	Model model;
+	if (!model.Load(argv[2])) {
+		return EXIT_FAILURE;
+	}
+	ThreadPool pool;
+	BatchScorer scorer(model, pool, kScoreChunkRows);
+	if (!scorer.Score(argv[3], argv[4])) {
+		return EXIT_FAILURE;
+	}
+	std::clog << "Scored " << scorer.GetRowCount() << " rows" << std::endl;
+	return 0;
+}
+int VerifyMain(int argc, char *argv[]) {
+	/* The double paths add up in the reference order, so match closely */
+	const double kTolerance = 1e-12;
+	const double kSingleTolerance = 1e-3;
+
+	if (argc != 3 && argc != 4) {
+		std::cerr << "Usage: " << argv[0]
+				  << " --verify <input file> [tolerance]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	double tolerance = kTolerance;
+	if (argc == 4) {
+		char *end = nullptr;
+		tolerance = std::strtod(argv[3], &end);
+		if (end == argv[3] || *end != '\0' || !(tolerance >= 0)) {
+			std::cerr << "Invalid tolerance: " << argv[3] << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	std::vector<SolutionData> solutions(ParseInput(argv[2]));
+	EvaluatorCheck check(solutions);
+	if (!check.Run(tolerance, kSingleTolerance)) {
+		return EXIT_FAILURE;
+	}
+	std::clog << "All evaluators match Node::Evaluate" << std::endl;
+	return 0;
+}
+int CheckTraceMain(int argc, char *argv[]) {
+	if (argc != 4) {
+		std::cerr << "Usage: " << argv[0]
+				  << " --check-trace <golden trace> <trace>" << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (!ReplayTrace::Compare(argv[2], argv[3])) {
+		return EXIT_FAILURE;
+	}
+	std::clog << "Traces match" << std::endl;
 	return 0;
 }
 std::vector<SolutionData> ParseInput(std::string filename) {
@@ -115,22 +315,28 @@ std::vector<SolutionData> ParseInput(std::string filename) {
 	inf.close();
 	return solutions;
 }
-std::string GetOutputDataString(size_t evolution_count, Population &p) {
-	std::stringstream ss;
-	char delim = ',';
-	
-	ss << evolution_count << delim;
-	ss << p.GetBestFitness() << delim;
-	ss << p.GetWorstFitness() << delim;
-	ss << p.GetAverageFitness() << delim;
-	//ss << p.GetBestWeightedFitness() << delim;
-	//ss << p.GetWorstWeightedFitness() << delim;
-	//ss << p.GetAverageWeightedFitness() << delim;
-	ss << p.GetSmallestTreeSize() << delim;
-	ss << p.GetLargestTreeSize() << delim;
-	ss << p.GetAverageTreeSize() << delim;
-	ss << p.GetBestSolutionToString(false,true);
-	//ss << p.GetBestWeightedSolutionToString(false,true);
-
-	return ss.str();
+void GetGenerationStats(size_t evolution_count, Population &p,
+						bool render_best, GenerationStats &stats) {
+	stats.generation = evolution_count;
+	stats.best_fitness = p.GetBestFitness();
+	stats.worst_fitness = p.GetWorstFitness();
+	stats.avg_fitness = p.GetAverageFitness();
+	stats.best_weighted_fitness = p.GetBestWeightedFitness();
+	stats.worst_weighted_fitness = p.GetWorstWeightedFitness();
+	stats.avg_weighted_fitness = p.GetAverageWeightedFitness();
+	stats.smallest_tree = p.GetSmallestTreeSize();
+	stats.largest_tree = p.GetLargestTreeSize();
+	stats.avg_tree = p.GetAverageTreeSize();
+	stats.deepest_tree = p.GetDeepestTreeDepth();
+	stats.avg_depth = p.GetAverageTreeDepth();
+	stats.rejected_crossovers = p.GetRejectedCrossoverCount();
+	stats.parsimony_coefficient = p.GetParsimonyCoefficient();
+	stats.semantic_diversity = p.GetSemanticDiversity();
+	stats.structural_diversity = p.GetStructuralDiversity();
+	stats.best_changed = render_best;
+	stats.best_solution.clear();
+	if (render_best) {
+		p.RenderBestSolution(stats.best_solution, false, kLatex);
+		//p.RenderBestWeightedSolution(stats.best_solution, false, kLatex);
+	}
 }
\ No newline at end of file
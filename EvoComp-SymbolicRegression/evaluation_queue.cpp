@@ -0,0 +1,161 @@
+/*
+* evaluation_queue.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Implementation of EvaluationQueue class
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "evaluation_queue.h"
+
+EvaluationQueue::EvaluationQueue(size_t worker_count, bool size_priority,
+								 bool ordered_results,
+								 const Evaluator &evaluate,
+								 const NumaTopology *topology)
+	: evaluate_(evaluate), waiting_(TaskOrder{ size_priority }) {
+	if (worker_count == 0) {
+		worker_count = std::thread::hardware_concurrency();
+	}
+	if (worker_count == 0) {
+		worker_count = 1;
+	}
+	stopping_ = false;
+	ordered_results_ = ordered_results;
+	next_sequence_ = 0;
+	next_result_ = 0;
+	pending_ = 0;
+	for (size_t i = 0; i < worker_count; ++i) {
+		size_t node = topology ? i % topology->GetNodeCount() : 0;
+		workers_.push_back(std::thread(&EvaluationQueue::WorkerLoop, this,
+									   topology, node));
+	}
+}
+EvaluationQueue::~EvaluationQueue() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	task_ready_.notify_all();
+	for (auto &w : workers_) {
+		w.join();
+	}
+
+	/* Anything still queued was never handed back, so its tree is ours */
+	while (!waiting_.empty()) {
+		waiting_.top()->individual.Erase();
+		delete waiting_.top();
+		waiting_.pop();
+	}
+	for (auto task : finished_) {
+		task->individual.Erase();
+		delete task;
+	}
+}
+void EvaluationQueue::Submit(std::unique_ptr<EvaluationTask> task) {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		task->sequence = next_sequence_++;
+		waiting_.push(task.release());
+		++pending_;
+	}
+	task_ready_.notify_one();
+}
+std::unique_ptr<EvaluationTask> EvaluationQueue::WaitForResult() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (pending_ == 0) {
+		return nullptr;
+	}
+	EvaluationTask *task = nullptr;
+	result_ready_.wait(lock, [this, &task] {
+		task = TakeFinished();
+		return task != nullptr;
+	});
+	--pending_;
+	return std::unique_ptr<EvaluationTask>(task);
+}
+std::unique_ptr<EvaluationTask> EvaluationQueue::PollResult() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	EvaluationTask *task = TakeFinished();
+	if (!task) {
+		return nullptr;
+	}
+	--pending_;
+	return std::unique_ptr<EvaluationTask>(task);
+}
+size_t EvaluationQueue::GetPendingCount() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pending_;
+}
+size_t EvaluationQueue::GetWorkerCount() {
+	return workers_.size();
+}
+
+/* Private Helper Functions */
+bool EvaluationQueue::TaskOrder::operator()(const EvaluationTask *a,
+											const EvaluationTask *b) const {
+	/* The queue pops its greatest task; ties go to the earliest submitted */
+	if (size_priority && a->priority != b->priority) {
+		return a->priority < b->priority;
+	}
+	return a->sequence > b->sequence;
+}
+void EvaluationQueue::WorkerLoop(const NumaTopology *topology,
+								 size_t node) {
+	if (topology) {
+		topology->PinThread(node);
+	}
+	for (;;) {
+		EvaluationTask *task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			task_ready_.wait(lock, [this] {
+				return stopping_ || !waiting_.empty();
+			});
+			if (stopping_) {
+				return;
+			}
+			task = waiting_.top();
+			waiting_.pop();
+		}
+		evaluate_(*task);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			finished_.push_back(task);
+		}
+		result_ready_.notify_one();
+	}
+}
+EvaluationTask* EvaluationQueue::TakeFinished() {
+	/*
+	 * Called with mutex_ held.  Ordered results wait for the oldest
+	 * outstanding task even when later ones are already done; the list
+	 * is at most a few in-flight tasks long, so a scan is enough.
+	 */
+	auto it = finished_.begin();
+	if (ordered_results_) {
+		while (it != finished_.end() && (*it)->sequence != next_result_) {
+			++it;
+		}
+	}
+	if (it == finished_.end()) {
+		return nullptr;
+	}
+	EvaluationTask *task = *it;
+	finished_.erase(it);
+	++next_result_;
+	return task;
+}
@@ -0,0 +1,102 @@
+/*
+* evaluation_queue.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for EvaluationQueue class - worker threads that evaluate
+* submitted individuals and hand them back as each one finishes
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "individual.h"
+#include "numa_topology.h"
+
+/* A detached individual on its way through the queue */
+struct EvaluationTask {
+	Individual individual;
+	std::vector<float> case_errors; /* Filled when errors are tracked */
+	size_t simplified_nodes;
+	size_t priority; /* Larger starts first when priority is on */
+	uint64_t sequence; /* Submission order, set by the queue */
+};
+
+class EvaluationQueue {
+public:
+	typedef std::function<void(EvaluationTask&)> Evaluator;
+
+	/*
+	 * Starts worker_count threads (0 uses every hardware thread) that
+	 * call evaluate on submitted tasks.  With size_priority the pending
+	 * task with the largest priority starts first, so one huge tree
+	 * starts early instead of holding up the end of a batch; otherwise
+	 * tasks start in submission order.  With ordered_results finished
+	 * tasks are handed back in submission order rather than as they
+	 * finish, so the caller sees the same sequence on every run.  A
+	 * topology pins the workers as ThreadPool does.
+	 */
+	EvaluationQueue(size_t worker_count, bool size_priority,
+					bool ordered_results, const Evaluator &evaluate,
+					const NumaTopology *topology = nullptr);
+	~EvaluationQueue();
+
+	void Submit(std::unique_ptr<EvaluationTask> task);
+	
+	/* Blocks until a task can be handed back */
+	std::unique_ptr<EvaluationTask> WaitForResult();
+	
+	/* Returns a finished task without blocking, or null */
+	std::unique_ptr<EvaluationTask> PollResult();
+	
+	/* Submitted tasks that have not been handed back yet */
+	size_t GetPendingCount();
+	size_t GetWorkerCount();
+private:
+	struct TaskOrder {
+		bool size_priority;
+		bool operator()(const EvaluationTask *a,
+						const EvaluationTask *b) const;
+	};
+	void WorkerLoop(const NumaTopology *topology, size_t node);
+	EvaluationTask* TakeFinished();
+
+	Evaluator evaluate_;
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	std::condition_variable task_ready_;
+	std::condition_variable result_ready_;
+	bool stopping_;
+	bool ordered_results_;
+	uint64_t next_sequence_;
+	uint64_t next_result_; /* Sequence handed back next when ordered */
+	size_t pending_;
+
+	/* Owned raw pointers while inside the queue */
+	std::priority_queue<EvaluationTask*, std::vector<EvaluationTask*>,
+		TaskOrder> waiting_;
+	std::deque<EvaluationTask*> finished_;
+};
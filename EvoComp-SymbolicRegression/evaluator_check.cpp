@@ -0,0 +1,187 @@
+/*
+* evaluator_check.cpp
+* UIdaho CS-572: Evolutionary Computation
+* EvaluatorCheck class - checks the optimized evaluators against the
+* reference Node::Evaluate on random trees.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "evaluator_check.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "node_context.h"
+#include "program.h"
+#include "subtree_cache.h"
+
+EvaluatorCheck::EvaluatorCheck(const std::vector<SolutionData> &solutions,
+							   size_t tree_count, uint32_t seed)
+	: solutions_(solutions), data_(solutions), intervals_(data_),
+	  rng_(seed) {
+	tree_count_ = tree_count;
+	data_.BuildSinglePrecision();
+}
+bool EvaluatorCheck::Run(double tolerance, double single_tolerance) {
+	/* Arithmetic only, then everything, so both evaluator subsets run */
+	bool passed = CheckOperators("+ - * /", tolerance, single_tolerance);
+	passed &= CheckOperators("+ - * / sin cos exp log sqrt sq", tolerance,
+							 single_tolerance);
+	return passed;
+}
+
+/* Private Helper Functions */
+bool EvaluatorCheck::CheckOperators(const std::string &names,
+									double tolerance,
+									double single_tolerance) {
+	const size_t kTileRows = 64;
+	const size_t kDepthMax = 6;
+	const size_t kCacheBytes = 64 << 20;
+
+	OperatorSet operators(names);
+	size_t input_count = data_.GetColumnCount();
+	NodeContext context(input_count - 1, -10.0, 10.0);
+	BlockEvaluator evaluator = SelectBlockEvaluator(input_count, operators);
+	size_t rows = data_.GetRowCount();
+
+	PathResult batched = { "batched", tolerance, true, 0, 0, "" };
+	PathResult tiled = { "tiled", tolerance, true, 0, 0, "" };
+	PathResult program = { "program", tolerance, true, 0, 0, "" };
+	PathResult specialized = { "specialized", tolerance, true, 0, 0, "" };
+	PathResult cached = { "cached", tolerance, true, 0, 0, "" };
+	PathResult single = { "single", single_tolerance, false, 0, 0, "" };
+	PathResult settled = { "interval", tolerance, true, 0, 0, "" };
+	size_t constant_count = 0;
+	size_t nonfinite_count = 0;
+	SubtreeCache cache(kCacheBytes);
+
+	for (size_t t = 0; t < tree_count_; ++t) {
+		size_t depth = 1 + t % kDepthMax;
+		Individual individual(context, depth, t % 2 == 0, operators, rng_);
+		Node *root = individual.GetRootNode();
+		Program compiled;
+		compiled.Compile(root);
+
+		/* Reference error, added up in row order like the batched path */
+		double reference_error = 0;
+		double program_error = 0;
+		for (auto &s : solutions_) {
+			double diff = s.y - root->Evaluate(s.x);
+			reference_error += diff * diff;
+			diff = s.y - compiled.Evaluate(s.x.data());
+			program_error += diff * diff;
+		}
+		double reference = sqrt(reference_error / rows);
+		Compare(program, reference, sqrt(program_error / rows), individual);
+
+		individual.CalculateFitness(data_);
+		Compare(batched, reference, individual.GetFitness(), individual);
+		if (evaluator) {
+			individual.CalculateFitness(data_, nullptr, 1, kDoublePrecision,
+										nullptr, evaluator);
+			Compare(specialized, reference, individual.GetFitness(),
+					individual);
+		}
+		individual.CalculateFitness(data_, nullptr, 1, kSinglePrecision);
+		Compare(single, reference, individual.GetFitness(), individual);
+
+		/* The first pass fills the cache and the second reads it back */
+		individual.CalculateFitness(data_, nullptr, 1, kDoublePrecision,
+									&cache);
+		individual.CalculateFitness(data_, nullptr, 1, kDoublePrecision,
+									&cache);
+		Compare(cached, reference, individual.GetFitness(), individual);
+
+		double tiled_error = 0;
+		for (size_t begin = 0; begin < rows; begin += kTileRows) {
+			tiled_error += individual.CalculateSquaredError(data_, begin,
+				std::min(kTileRows, rows - begin));
+		}
+		Compare(tiled, reference, sqrt(tiled_error / rows), individual);
+
+		/* A settled tree's error must be the reference's, NaN included */
+		double constant = 0;
+		switch (intervals_.Classify(root, constant)) {
+		case kConstantOutput:
+			++constant_count;
+			Compare(settled, reference,
+					intervals_.ConstantError(constant, rows), individual);
+			break;
+		case kNonFiniteOutput:
+			++nonfinite_count;
+			Compare(settled, reference,
+					intervals_.ConstantError(constant, rows), individual);
+			break;
+		default:
+			break;
+		}
+		individual.Erase();
+	}
+
+	std::clog << "Operators \"" << names << "\", " << tree_count_
+			  << " trees, " << rows << " rows" << std::endl;
+	bool passed = Report(batched);
+	passed &= Report(tiled);
+	passed &= Report(single);
+	passed &= Report(cached);
+	passed &= Report(program);
+	if (evaluator) {
+		passed &= Report(specialized);
+	} else {
+		std::clog << "  specialized: none for " << input_count << " inputs"
+				  << std::endl;
+	}
+	std::clog << "  settled by intervals: " << constant_count << " constant, "
+			  << nonfinite_count << " non-finite" << std::endl;
+	passed &= Report(settled);
+	return passed;
+}
+void EvaluatorCheck::Compare(PathResult &path, double reference,
+							 double actual, Individual &individual) {
+	/*
+	 * Non-finite results must agree in kind: NaN with NaN and infinities
+	 * of the same sign.  Anything else is off by an infinite amount.
+	 */
+	double difference;
+	if (std::isnan(reference) || std::isnan(actual)) {
+		difference = (std::isnan(reference) && std::isnan(actual)) ?
+			0 : INFINITY;
+	} else if (std::isinf(reference) || std::isinf(actual)) {
+		difference = (reference == actual) ? 0 : INFINITY;
+	} else {
+		difference = std::fabs(actual - reference) /
+			std::max(1.0, std::fabs(reference));
+	}
+	if (difference > path.tolerance) {
+		++path.over_count;
+	}
+	if (difference > path.max_difference) {
+		path.max_difference = difference;
+		path.worst_tree = individual.ToString(false);
+	}
+}
+bool EvaluatorCheck::Report(const PathResult &path) {
+	std::clog << "  " << path.name << ": largest difference "
+			  << path.max_difference << ", " << path.over_count
+			  << " trees over " << path.tolerance << std::endl;
+	if (path.required && path.over_count > 0) {
+		std::cerr << path.name << " evaluator exceeds its tolerance on "
+				  << path.worst_tree << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,80 @@
+/*
+* evaluator_check.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for EvaluatorCheck class - checks the optimized evaluators against
+* the reference Node::Evaluate on random trees
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "dataset.h"
+#include "individual.h"
+#include "interval_analysis.h"
+#include "operator_set.h"
+#include "solution_data.h"
+
+/*
+ * Grows random trees over the training data for an arithmetic and a full
+ * operator set and scores every tree both with the reference,
+ * Node::Evaluate one row at a time, and with each optimized path:
+ * block-batched fitness, the same with the specialized block evaluator,
+ * tiled squared errors, the compiled Program, and a second fitness pass
+ * served from a SubtreeCache.  Trees the interval analysis settles are
+ * checked against the reference too, inf and NaN errors included.  A path
+ * passes when no tree differs from the reference by more than its
+ * tolerance, taken relative to the reference or absolute below 1.  Single
+ * precision is reported but cannot fail, since float overflows where
+ * double does not; that is what the double re-score of the best
+ * individuals is for.  Results go to clog, failures to cerr.
+ */
+class EvaluatorCheck {
+public:
+	EvaluatorCheck(const std::vector<SolutionData> &solutions,
+				   size_t tree_count = 500, uint32_t seed = 1);
+
+	/* single_tolerance only sets what the single report counts */
+	bool Run(double tolerance, double single_tolerance);
+private:
+	/* Largest difference seen on one path, and the tree it came from */
+	struct PathResult {
+		std::string name;
+		double tolerance;
+		bool required; /* Exceeding the tolerance fails the check */
+		double max_difference;
+		size_t over_count; /* Trees beyond the tolerance */
+		std::string worst_tree;
+	};
+
+	bool CheckOperators(const std::string &names, double tolerance,
+						double single_tolerance);
+	void Compare(PathResult &path, double reference, double actual,
+				 Individual &individual);
+	bool Report(const PathResult &path);
+
+	const std::vector<SolutionData> &solutions_;
+	Dataset data_;
+	IntervalAnalysis intervals_;
+	size_t tree_count_;
+	std::mt19937 rng_;
+};
@@ -0,0 +1,52 @@
+/*
+* generation_stats.h
+* UIdaho CS-572: Evolutionary Computation
+* Structure representing the statistics of a single generation
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+ * Plain copy of the numbers written to the run log each generation.  The
+ * best solution is only rendered when it differs from the previous
+ * generation; otherwise best_changed is false and best_solution is empty.
+ */
+struct GenerationStats {
+	size_t generation;
+	double best_fitness;
+	double worst_fitness;
+	double avg_fitness;
+	double best_weighted_fitness;
+	double worst_weighted_fitness;
+	double avg_weighted_fitness;
+	size_t smallest_tree;
+	size_t largest_tree;
+	size_t avg_tree;
+	size_t deepest_tree;
+	size_t avg_depth;
+	size_t rejected_crossovers;
+	double parsimony_coefficient;
+	double semantic_diversity; /* Fraction of distinct fingerprints */
+	double structural_diversity; /* Fraction of distinct trees */
+	bool best_changed;
+	std::string best_solution;
+};
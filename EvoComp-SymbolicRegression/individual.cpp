@@ -22,96 +22,421 @@
 * along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "individual.h"
-#include <deque>
+#include <algorithm>
+#include <cmath>
+#include <cstring> /* For std::memcpy */
 #include <iostream>
+#include <limits>
 #include <random>
 #include <string>
 
-Individual::Individual(size_t var_count, double const_min, double const_max) {
-	root_ = new Node;
-	root_->SetVarCount(var_count);
-	root_->SetConstMin(const_min);
-	root_->SetConstMax(const_max);
+template <typename T>
+static double SquaredError(Node *root, const Dataset &data, size_t row_begin,
+						   size_t row_count, float *case_errors,
+						   size_t case_stride, SubtreeCache *cache,
+						   BlockEvaluator evaluator);
+static double SquaredError(Node *root, const Dataset &data, size_t row_begin,
+						   size_t row_count, float *case_errors,
+						   size_t case_stride, Precision precision,
+						   SubtreeCache *cache, BlockEvaluator evaluator);
+static double RootMeanSquaredError(Node *root, const Dataset &data,
+								   float *case_errors, size_t case_stride,
+								   Precision precision, SubtreeCache *cache,
+								   BlockEvaluator evaluator);
+static const double* EvaluateBlock(Node *root, const Dataset &data,
+								   size_t row_begin, size_t count,
+								   double *buffer, size_t block_rows,
+								   SubtreeCache *cache,
+								   const std::vector<uint64_t> &hashes,
+								   const std::vector<uint64_t> &checks,
+								   const std::vector<size_t> &sizes,
+								   BlockEvaluator evaluator,
+								   Program &program);
+static const float* EvaluateBlock(Node *root, const Dataset &data,
+								  size_t row_begin, size_t count,
+								  float *buffer, size_t block_rows,
+								  SubtreeCache *cache,
+								  const std::vector<uint64_t> &hashes,
+								  const std::vector<uint64_t> &checks,
+								  const std::vector<size_t> &sizes,
+								  BlockEvaluator evaluator,
+								  Program &program);
+static bool SolveLinearSystem(std::vector<double> &a, std::vector<double> &b,
+							  size_t n);
+static uint64_t QuantizeOutput(double value);
+
+Individual::Individual() {
+	/* No tree until one is generated or assigned, so nothing scored */
+	root_ = nullptr;
+	fitness_ = 0;
+	weighted_fitness_ = 0;
+	fingerprint_ = 0;
+	depth_ = 0;
+	dirty_ = true;
 }
-Individual::Individual() : Individual(0, 0, 0) {}
-Individual::Individual(size_t var_count, double const_min, double const_max,
-	size_t depth_max, bool full_tree) 
-	: Individual(var_count, const_min, const_max) {
-	this->GenerateTree(depth_max, full_tree);
+Individual::Individual(const NodeContext &context, size_t depth_max,
+	bool full_tree, const OperatorSet &operators, std::mt19937 &mt)
+	: Individual() {
+	this->GenerateTree(depth_max, full_tree, context, operators, mt);
 }
-Individual::Individual(const Individual &to_copy) {
-	root_ = new Node;
-	root_->Copy(to_copy.root_);
+Individual::Individual(const Individual &to_copy) : Individual() {
+	/* A deep copy: the new individual owns its own copy of the tree */
 	fitness_ = to_copy.fitness_;
-	terminal_count_ = to_copy.terminal_count_;
-	nonterminal_count_ = to_copy.nonterminal_count_;
-
-	CorrectTree();
+	weighted_fitness_ = to_copy.weighted_fitness_;
+	fingerprint_ = to_copy.fingerprint_;
+	if (to_copy.root_) {
+		root_ = new Node;
+		root_->Copy(to_copy.root_);
+		CorrectTree();
+	}
+	dirty_ = to_copy.dirty_; /* Same tree, so the fitness still holds */
+}
+Individual& Individual::operator=(const Individual &to_copy) {
+	/*
+	 * Shallow: both individuals share one tree afterwards, so only one
+	 * of them may Erase it.  Population moves trees between slots this
+	 * way; the copy constructor is the deep copy.
+	 */
+	root_ = to_copy.root_;
+	fitness_ = to_copy.fitness_;
+	weighted_fitness_ = to_copy.weighted_fitness_;
+	fingerprint_ = to_copy.fingerprint_;
+	depth_ = to_copy.depth_;
+	dirty_ = to_copy.dirty_;
+	terminals_ = to_copy.terminals_;
+	nonterminals_ = to_copy.nonterminals_;
+	return *this;
 }
 void Individual::Copy(Individual *to_copy) {
-	root_ = to_copy->root_;
-	fitness_ = to_copy->fitness_;
-	terminal_count_ = to_copy->terminal_count_;
-	nonterminal_count_ = to_copy->nonterminal_count_;
+	*this = *to_copy;
 }
 void Individual::Erase() {
-	root_->Erase();
+	/*
+	 * Frees the tree.  Assignment between individuals is shallow, so
+	 * whoever overwrites an individual that owns a tree must Erase it
+	 * first, and a tree must only ever be erased through one owner.
+	 */
+	if (root_) {
+		root_->Erase();
+		root_ = nullptr;
+	}
+	terminals_.clear();
+	nonterminals_.clear();
+	dirty_ = true;
 }
 std::string Individual::ToString(bool latex) {
 	return root_->ToString(latex);
 }
+void Individual::Render(std::string &out, RenderFormat format) {
+	root_->Render(out, format);
+}
+uint64_t Individual::Hash() {
+	return root_->Hash();
+}
 
 /* Genetic Program Functions */
-void Individual::GenerateTree(size_t depth_max, bool full_tree) {
-	root_->GenerateTree(0, depth_max, nullptr, full_tree);
+void Individual::GenerateTree(size_t depth_max, bool full_tree,
+							  const NodeContext &context,
+							  const OperatorSet &operators, std::mt19937 &mt) {
+	/* Any previous tree is the caller's to Erase */
+	root_ = new Node;
+	root_->GenerateTree(0, depth_max, nullptr, full_tree, context, operators,
+						mt);
+	CalculateTreeSize();
+	dirty_ = true;
+}
+void Individual::GenerateTreePTC2(size_t target_size, size_t depth_max,
+								  const NodeContext &context,
+								  const OperatorSet &operators,
+								  std::mt19937 &mt) {
+	root_ = new Node;
+	root_->GenerateTreePTC2(target_size, depth_max, context, operators, mt);
 	CalculateTreeSize();
+	dirty_ = true;
 }
-void Individual::Mutate(double mutation_rate) {
-	root_->Mutate(mutation_rate);
+void Individual::Mutate(double mutation_rate, const NodeContext &context,
+						const OperatorSet &operators, std::mt19937 &mt) {
+	/*
+	 * Every node mutates independently with probability mutation_rate,
+	 * so the gaps between mutated positions are geometric.  Drawing the
+	 * gaps and jumping through the position tables (nonterminals, then
+	 * terminals) costs a draw per mutation rather than one per node.
+	 * Mutation never changes the shape, so the tables stay valid.
+	 */
+	if (mutation_rate <= 0) {
+		return;
+	}
+	std::geometric_distribution<size_t> gap(std::min(mutation_rate, 1.0));
+	size_t nonterminal_count = nonterminals_.size();
+	size_t size = nonterminal_count + terminals_.size();
+	for (size_t pos = gap(mt); pos < size; pos += gap(mt) + 1) {
+		Node *node = (pos < nonterminal_count) ?
+			nonterminals_[pos] : terminals_[pos - nonterminal_count];
+		node->Mutate(context, operators, mt);
+		dirty_ = true;
+	}
 }
-std::pair<Node*, bool> Individual::GetRandomNode(bool nonterminal) {
+size_t Individual::Simplify() {
+	/* Simplifies the genotype in place and returns the nodes removed */
+	size_t old_size = GetTreeSize();
+	root_->Simplify();
+	CalculateTreeSize();
+	if (GetTreeSize() != old_size) {
+		dirty_ = true;
+	}
+	return old_size - GetTreeSize();
+}
+bool Individual::OptimizeConstants(const Dataset &data,
+								   size_t iterations) {
+	/*
+	 * Levenberg-Marquardt on the kConst leaves against the squared error.
+	 * The Jacobian of the tree output with respect to each constant comes
+	 * from a reverse-mode pass per row, and J'J and J'r are accumulated
+	 * row by row so J itself is never stored.  Constants are only kept if
+	 * they lower the error.  Trial steps are scored on the tree compiled
+	 * to a Program, which only needs its constants patched between steps.
+	 * Each row is gathered from the columns into x just before it is
+	 * used.  Returns whether any constant changed; if so the individual
+	 * is left dirty for the caller to score again.
+	 *
+	 * Trees without a variable are left alone.  Tuned, a constant tree
+	 * becomes the mean of the targets, which can outscore every young
+	 * tree and, once it fills the elites, crowd out all growth.
+	 */
+	std::vector<Node*> consts;
+	bool has_var = false;
+	for (auto t : terminals_) {
+		if (t->GetOpType() == kConst) {
+			consts.push_back(t);
+		} else if (t->GetOpType() == kVar) {
+			has_var = true;
+		}
+	}
+	size_t p = consts.size();
+	size_t rows = data.GetRowCount();
+	if (p == 0 || !has_var || rows == 0) {
+		return false;
+	}
+	size_t inputs = data.GetColumnCount();
+	std::vector<const double*> columns(inputs);
+	for (size_t c = 0; c < inputs; ++c) {
+		columns[c] = data.GetColumn<double>(c);
+	}
+	const double *targets = data.GetTargets();
+	std::vector<double> x(inputs);
+
+	std::vector<double> values(p);
+	std::vector<double> gradient(p);
+	std::vector<double> jtj(p * p);
+	std::vector<double> jtr(p);
+	std::vector<double> system(p * p);
+	std::vector<double> step(p);
+	std::vector<double> tape;
+	double lambda = 1e-3;
+	double sse = 0;
+	bool recompute = true;
+	bool changed = false;
+	Program program;
+	program.Compile(root_);
+
+	for (size_t k = 0; k < p; ++k) {
+		values[k] = consts[k]->GetConstValue();
+	}
+	for (size_t it = 0; it < iterations; ++it) {
+		if (recompute) {
+			std::fill(jtj.begin(), jtj.end(), 0.0);
+			std::fill(jtr.begin(), jtr.end(), 0.0);
+			sse = 0;
+			for (size_t r = 0; r < rows; ++r) {
+				for (size_t c = 0; c < inputs; ++c) {
+					x[c] = columns[c][r];
+				}
+				size_t tape_pos = 0;
+				size_t const_pos = 0;
+				tape.clear();
+				double residual = targets[r] - root_->EvaluateTape(x, tape);
+				std::fill(gradient.begin(), gradient.end(), 0.0);
+				root_->Backpropagate(tape.data(), tape_pos, 1.0,
+									 gradient.data(), const_pos);
+				sse += residual * residual;
+				for (size_t a = 0; a < p; ++a) {
+					jtr[a] += gradient[a] * residual;
+					for (size_t b = 0; b <= a; ++b) {
+						jtj[a * p + b] += gradient[a] * gradient[b];
+					}
+				}
+			}
+			if (!std::isfinite(sse)) {
+				break;
+			}
+			recompute = false;
+		}
+
+		/* Solve (J'J + lambda * diag(J'J)) step = J'r */
+		for (size_t a = 0; a < p; ++a) {
+			for (size_t b = 0; b <= a; ++b) {
+				system[a * p + b] = jtj[a * p + b];
+				system[b * p + a] = jtj[a * p + b];
+			}
+			system[a * p + a] += lambda * jtj[a * p + a] + 1e-12;
+			step[a] = jtr[a];
+		}
+		if (!SolveLinearSystem(system, step, p)) {
+			lambda *= 10;
+			continue;
+		}
+
+		for (size_t k = 0; k < p; ++k) {
+			consts[k]->SetConstValue(values[k] + step[k]);
+			program.SetConstant(k, values[k] + step[k]);
+		}
+		double trial = 0;
+		for (size_t r = 0; r < rows; ++r) {
+			for (size_t c = 0; c < inputs; ++c) {
+				x[c] = columns[c][r];
+			}
+			double residual = targets[r] - program.Evaluate(x.data());
+			trial += residual * residual;
+		}
+		if (trial < sse) {
+			for (size_t k = 0; k < p; ++k) {
+				values[k] += step[k];
+			}
+			bool converged = (sse - trial) <= 1e-12 * sse;
+			changed = true;
+			lambda /= 10;
+			sse = trial;
+			recompute = true;
+			if (converged) {
+				break;
+			}
+		} else {
+			for (size_t k = 0; k < p; ++k) {
+				consts[k]->SetConstValue(values[k]);
+				program.SetConstant(k, values[k]);
+			}
+			lambda *= 10;
+			if (lambda > 1e12) {
+				break;
+			}
+		}
+	}
+	if (changed) {
+		dirty_ = true;
+	}
+	return changed;
+}
+std::pair<Node*, bool> Individual::GetRandomNode(bool nonterminal,
+												 std::mt19937 &mt) {
 	/* Returned bool is true for left child and false for right child. */
-	/* Can return nullptr, which means that entire tree will be replaced. */
-	std::random_device rd;
-	std::mt19937 mt(rd());
-	size_t upper_bound;
-	size_t countdown;
+	/* Returning the root means that entire tree will be replaced. */
+	std::vector<Node*> &table = nonterminal ? nonterminals_ : terminals_;
 
 	/* Even if nonterminal is true, return root node if it's the only node */
-	if (nonterminal_count_ == 0) {
+	if (nonterminals_.empty()) {
 		return std::pair<Node*, bool>(root_, nonterminal);
 	}
 
-	if (nonterminal) {
-		upper_bound = nonterminal_count_ - 1;
-	} else {
-		upper_bound = terminal_count_ - 1;
-	}
-	std::uniform_int_distribution<size_t> d{ 0,upper_bound };
-	countdown = d(mt);
+	std::uniform_int_distribution<size_t> d{ 0,table.size() - 1 };
+	Node *node = table[d(mt)];
+	Node *parent = node->GetParent();
 
-	return root_->SelectNode(countdown, nonterminal);
+	return std::pair<Node*, bool>(node,
+								  !parent || parent->GetLeftChild() == node);
 }
 
 /* Helper Functions */
 void Individual::CalculateTreeSize() {
-	terminal_count_ = 0;
-	nonterminal_count_ = 0;
-	root_->CountNodes(terminal_count_, nonterminal_count_);
+	terminals_.clear();
+	nonterminals_.clear();
+	root_->IndexNodes(terminals_, nonterminals_);
+	depth_ = root_->GetHeight();
 }
-void Individual::CalculateFitness(std::vector<SolutionData> solutions) {
-	fitness_ = 0.0;
-	for (size_t i = 0; i < solutions.size(); ++i) {
-		fitness_ += pow(solutions[i].y - root_->Evaluate(solutions[i].x), 2);
-	}
-	fitness_ = sqrt(fitness_ / solutions.size());
+void Individual::CalculateFitness(const Dataset &data,
+								  float *case_errors, size_t case_stride,
+								  Precision precision, SubtreeCache *cache,
+								  BlockEvaluator evaluator) {
+	/*
+	 * When case_errors is given, the absolute error on case i is also
+	 * written to case_errors[i * case_stride].  A cache or a specialized
+	 * evaluator, if given, is only used in double precision, and the
+	 * cache takes precedence.
+	 */
+	fitness_ = RootMeanSquaredError(root_, data, case_errors, case_stride,
+									precision, cache, evaluator);
+	dirty_ = false;
+}
+size_t Individual::CalculateSimplifiedFitness(const Dataset &data,
+	float *case_errors, size_t case_stride, Precision precision,
+	SubtreeCache *cache, BlockEvaluator evaluator) {
+	/*
+	 * Evaluates a simplified copy of the tree so the genotype itself is
+	 * left intact for crossover.  Returns the nodes the copy saved.
+	 */
+	size_t term_count = 0;
+	size_t nonterm_count = 0;
+	Node *simplified = new Node;
+
+	simplified->Copy(root_);
+	simplified->CorrectParents(nullptr);
+	simplified->Simplify();
+	simplified->CountNodes(term_count, nonterm_count);
+
+	fitness_ = RootMeanSquaredError(simplified, data, case_errors,
+									case_stride, precision, cache, evaluator);
+	simplified->Erase();
+	dirty_ = false;
+	return GetTreeSize() - (term_count + nonterm_count);
+}
+double Individual::CalculateSquaredError(const Dataset &data,
+	size_t row_begin, size_t row_count, float *case_errors,
+	size_t case_stride, Precision precision, SubtreeCache *cache,
+	BlockEvaluator evaluator) {
+	/*
+	 * The sum of squared errors over one range of rows, for callers that
+	 * split the rows up themselves.  The fitness is left alone.
+	 */
+	return SquaredError(root_, data, row_begin, row_count, case_errors,
+						case_stride, precision, cache, evaluator);
+}
+size_t Individual::GetMemoryUsage() {
+	/*
+	 * Bytes held by this individual: itself, its nodes and its position
+	 * tables.  Allocator overhead per node is not included.
+	 */
+	return sizeof(Individual) + GetTreeSize() * sizeof(Node) +
+		(terminals_.capacity() + nonterminals_.capacity()) * sizeof(Node*);
 }
 void Individual::CalculateWeightedFitness(double parsimony_coefficient) {
 	weighted_fitness_ = fitness_ + parsimony_coefficient * GetTreeSize();
 }
+uint64_t Individual::CalculateFingerprint(const Dataset &probe) {
+	/*
+	 * Semantic fingerprint: a hash of the tree's outputs on a few fixed
+	 * probe rows, each quantized so that trees which only differ by
+	 * rounding (x + x versus 2x, say) still collide.
+	 */
+	static thread_local std::vector<double> buffer;
+	size_t rows = probe.GetRowCount();
+	size_t needed = (root_->GetHeight() + 2) * rows;
+	if (buffer.size() < needed) {
+		buffer.resize(needed);
+	}
+	const double *out = root_->EvaluateBatch(probe, 0, rows, buffer.data(),
+											 buffer.data() + rows);
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < rows; ++i) {
+		h ^= QuantizeOutput(out[i]) + 0x9e3779b97f4a7c15ULL +
+			(h << 6) + (h >> 2);
+	}
+	fingerprint_ = h;
+	return h;
+}
 void Individual::CorrectTree() {
+	/* Called once the tree has been edited, so the fitness is stale */
 	root_->CorrectParents(nullptr);
 	CalculateTreeSize();
+	dirty_ = true;
 }
 
 
@@ -122,18 +447,208 @@ double Individual::GetFitness() {
 double Individual::GetWeightedFitness() {
 	return weighted_fitness_;
 }
+uint64_t Individual::GetFingerprint() {
+	return fingerprint_;
+}
+void Individual::SetFitness(double fitness) {
+	fitness_ = fitness;
+}
+bool Individual::IsDirty() {
+	return dirty_;
+}
+void Individual::SetDirty(bool dirty) {
+	dirty_ = dirty;
+}
+void Individual::SetWeightedFitness(double weighted_fitness) {
+	weighted_fitness_ = weighted_fitness;
+}
 size_t Individual::GetTreeSize() {
 	return this->GetTerminalCount() + this->GetNonTerminalCount();
 }
+size_t Individual::GetTreeDepth() {
+	return depth_;
+}
 size_t Individual::GetTerminalCount() {
-	return terminal_count_;
+	return terminals_.size();
 }
 size_t Individual::GetNonTerminalCount() {
-	return nonterminal_count_;
+	return nonterminals_.size();
 }
 Node* Individual::GetRootNode() {
 	return root_;
 }
 void Individual::SetRootNode(Node *root) {
 	root_ = root;
+	dirty_ = true;
+}
+
+static uint64_t QuantizeOutput(double value) {
+	/*
+	 * Rounds to float and then to the nearest 2^-15 of the mantissa,
+	 * about four and a half significant digits.  All NaNs are the same.
+	 */
+	if (value != value) {
+		return 0x7ff8000000000000ULL;
+	}
+	float rounded = static_cast<float>(value);
+	if (rounded == 0) {
+		return 0; /* +0 and -0 */
+	}
+	uint32_t bits;
+	std::memcpy(&bits, &rounded, sizeof(bits));
+	if ((bits & 0x7f800000u) != 0x7f800000u) {
+		bits = (bits + 0x80u) & ~0xffu; /* Leave inf alone */
+	}
+	return bits;
+}
+static bool SolveLinearSystem(std::vector<double> &a, std::vector<double> &b,
+							  size_t n) {
+	/* Gaussian elimination with partial pivoting; the answer ends up in b */
+	for (size_t col = 0; col < n; ++col) {
+		size_t pivot = col;
+		for (size_t row = col + 1; row < n; ++row) {
+			if (std::fabs(a[row * n + col]) > std::fabs(a[pivot * n + col])) {
+				pivot = row;
+			}
+		}
+		if (a[pivot * n + col] == 0 || !std::isfinite(a[pivot * n + col])) {
+			return false;
+		}
+		if (pivot != col) {
+			for (size_t k = 0; k < n; ++k) {
+				std::swap(a[col * n + k], a[pivot * n + k]);
+			}
+			std::swap(b[col], b[pivot]);
+		}
+		for (size_t row = col + 1; row < n; ++row) {
+			double factor = a[row * n + col] / a[col * n + col];
+			for (size_t k = col; k < n; ++k) {
+				a[row * n + k] -= factor * a[col * n + k];
+			}
+			b[row] -= factor * b[col];
+		}
+	}
+	for (size_t col = n; col-- > 0;) {
+		for (size_t k = col + 1; k < n; ++k) {
+			b[col] -= a[col * n + k] * b[k];
+		}
+		b[col] /= a[col * n + col];
+	}
+	return true;
+}
+static double RootMeanSquaredError(Node *root, const Dataset &data,
+								   float *case_errors, size_t case_stride,
+								   Precision precision, SubtreeCache *cache,
+								   BlockEvaluator evaluator) {
+	size_t rows = data.GetRowCount();
+	return sqrt(SquaredError(root, data, 0, rows, case_errors, case_stride,
+							 precision, cache, evaluator) / rows);
+}
+static double SquaredError(Node *root, const Dataset &data, size_t row_begin,
+						   size_t row_count, float *case_errors,
+						   size_t case_stride, Precision precision,
+						   SubtreeCache *cache, BlockEvaluator evaluator) {
+	/*
+	 * Cached columns are double and the specialized evaluators only come
+	 * in double, so the float path never uses either
+	 */
+	if (precision == kSinglePrecision) {
+		return SquaredError<float>(root, data, row_begin, row_count,
+								   case_errors, case_stride, nullptr,
+								   nullptr);
+	}
+	return SquaredError<double>(root, data, row_begin, row_count,
+								case_errors, case_stride, cache, evaluator);
+}
+template <typename T>
+static double SquaredError(Node *root, const Dataset &data, size_t row_begin,
+						   size_t row_count, float *case_errors,
+						   size_t case_stride, SubtreeCache *cache,
+						   BlockEvaluator evaluator) {
+	/*
+	 * Evaluates kBlockRows rows at a time with Node::EvaluateBatch, so
+	 * each node dispatches once per block instead of once per row.  The
+	 * buffers are per thread and only ever grow.  Trees may run in T, but
+	 * the residuals and their sum are always double.  Case errors are
+	 * indexed by absolute row.  With a cache, the subtree hashes are
+	 * worked out once up front, and blocks are longer so there are fewer
+	 * entries to look up and keep.  Otherwise, with a specialized
+	 * evaluator, the tree is compiled once up front and the blocks run
+	 * as flat code instead of a walk over the tree.
+	 */
+	const size_t kBlockRows = cache ? 1024 : 256;
+	static thread_local std::vector<T> buffer;
+	static thread_local std::vector<uint64_t> hashes;
+	static thread_local std::vector<uint64_t> checks;
+	static thread_local std::vector<size_t> sizes;
+	static thread_local Program program;
+	size_t row_end = row_begin + row_count;
+	size_t needed = (root->GetHeight() + 1) * kBlockRows;
+	if (cache) {
+		hashes.clear();
+		checks.clear();
+		sizes.clear();
+		root->HashNodes(hashes, checks, sizes);
+		evaluator = nullptr;
+	} else if (evaluator) {
+		program.Compile(root);
+		needed = std::max(needed, program.GetStackSize() * kBlockRows);
+	}
+	if (buffer.size() < needed) {
+		buffer.resize(needed);
+	}
+	const double *targets = data.GetTargets();
+
+	double error = 0.0;
+	for (size_t begin = row_begin; begin < row_end; begin += kBlockRows) {
+		size_t count = std::min(kBlockRows, row_end - begin);
+		const T *out = EvaluateBlock(root, data, begin, count, buffer.data(),
+									 kBlockRows, cache, hashes, checks, sizes,
+									 evaluator, program);
+		for (size_t i = 0; i < count; ++i) {
+			double diff = targets[begin + i] - out[i];
+			error += diff * diff;
+			if (case_errors) {
+				/* NaN would never survive lexicase, so treat it as inf */
+				float abs_diff = static_cast<float>(std::fabs(diff));
+				case_errors[(begin + i) * case_stride] =
+					(abs_diff == abs_diff) ?
+					abs_diff : std::numeric_limits<float>::infinity();
+			}
+		}
+	}
+	return error;
+}
+static const double* EvaluateBlock(Node *root, const Dataset &data,
+								   size_t row_begin, size_t count,
+								   double *buffer, size_t block_rows,
+								   SubtreeCache *cache,
+								   const std::vector<uint64_t> &hashes,
+								   const std::vector<uint64_t> &checks,
+								   const std::vector<size_t> &sizes,
+								   BlockEvaluator evaluator,
+								   Program &program) {
+	if (cache) {
+		return root->EvaluateCached(data, row_begin, count, buffer,
+									buffer + block_rows, *cache,
+									hashes.data(), checks.data(),
+									sizes.data(), 0);
+	}
+	if (evaluator) {
+		return program.EvaluateBlock(evaluator, data, row_begin, count,
+									 buffer);
+	}
+	return root->EvaluateBatch(data, row_begin, count, buffer,
+							   buffer + block_rows);
+}
+static const float* EvaluateBlock(Node *root, const Dataset &data,
+								  size_t row_begin, size_t count,
+								  float *buffer, size_t block_rows,
+								  SubtreeCache *,
+								  const std::vector<uint64_t> &,
+								  const std::vector<uint64_t> &,
+								  const std::vector<size_t> &,
+								  BlockEvaluator, Program &) {
+	return root->EvaluateBatch(data, row_begin, count, buffer,
+							   buffer + block_rows);
 }
@@ -23,38 +23,74 @@
 */
 #pragma once
 
+#include <cstdint>
+#include <random>
+#include <string>
 #include <utility>
 #include <vector>
+#include "dataset.h"
 #include "node.h"
-#include "solution_data.h"
+#include "node_context.h"
+#include "operator_set.h"
+#include "program.h"
+#include "subtree_cache.h"
 
 class Individual {
 public:
 	Individual();
-	Individual(size_t var_count, double const_min, double const_max);
-	Individual(size_t var_count, double const_min, double const_max,
-		size_t depth_max, bool full_tree);
+	Individual(const NodeContext &context, size_t depth_max,
+		bool full_tree, const OperatorSet &operators, std::mt19937 &mt);
 	Individual(const Individual &to_copy);
+	Individual& operator=(const Individual &to_copy);
 
 	void Copy(Individual *to_copy);
 	void Erase();
 	std::string ToString(bool latex);
+	void Render(std::string &out, RenderFormat format);
+	uint64_t Hash();
 	
 	/* Genetic Program Functions */
-	void GenerateTree(size_t depth_max, bool full_tree);
-	void Mutate(double mutation_rate);
-	std::pair<Node*, bool> GetRandomNode(bool nonterminal);
+	void GenerateTree(size_t depth_max, bool full_tree,
+					  const NodeContext &context,
+					  const OperatorSet &operators, std::mt19937 &mt);
+	void GenerateTreePTC2(size_t target_size, size_t depth_max,
+						  const NodeContext &context,
+						  const OperatorSet &operators, std::mt19937 &mt);
+	void Mutate(double mutation_rate, const NodeContext &context,
+				const OperatorSet &operators, std::mt19937 &mt);
+	size_t Simplify();
+	bool OptimizeConstants(const Dataset &data, size_t iterations);
+	std::pair<Node*, bool> GetRandomNode(bool nonterminal, std::mt19937 &mt);
 	
 	/* Public Helper Functions */
 	void CalculateTreeSize();
-	void CalculateFitness(std::vector<SolutionData> input_values);
+	void CalculateFitness(const Dataset &data,
+		float *case_errors = nullptr, size_t case_stride = 1,
+		Precision precision = kDoublePrecision,
+		SubtreeCache *cache = nullptr, BlockEvaluator evaluator = nullptr);
+	size_t CalculateSimplifiedFitness(const Dataset &data,
+		float *case_errors = nullptr, size_t case_stride = 1,
+		Precision precision = kDoublePrecision,
+		SubtreeCache *cache = nullptr, BlockEvaluator evaluator = nullptr);
+	double CalculateSquaredError(const Dataset &data, size_t row_begin,
+		size_t row_count, float *case_errors = nullptr,
+		size_t case_stride = 1, Precision precision = kDoublePrecision,
+		SubtreeCache *cache = nullptr, BlockEvaluator evaluator = nullptr);
 	void CalculateWeightedFitness(double parsimony_coefficient);
+	size_t GetMemoryUsage();
+	uint64_t CalculateFingerprint(const Dataset &probe);
 	void CorrectTree();
 
 	/* Private Accessors/Mutators */
 	double GetFitness();
 	double GetWeightedFitness();
+	uint64_t GetFingerprint();
+	void SetFitness(double fitness);
+	bool IsDirty();
+	void SetDirty(bool dirty);
+	void SetWeightedFitness(double weighted_fitness);
 	size_t GetTreeSize();
+	size_t GetTreeDepth();
 	size_t GetTerminalCount();
 	size_t GetNonTerminalCount();
 	Node* GetRootNode();
@@ -63,6 +99,11 @@ private:
 	Node *root_;
 	double fitness_;
 	double weighted_fitness_;
-	size_t terminal_count_;
-	size_t nonterminal_count_;
+	uint64_t fingerprint_; /* Hash of the outputs on the probe rows */
+	size_t depth_;
+	bool dirty_; /* Tree changed since fitness_ was last calculated */
+
+	/* Preorder position tables, rebuilt whenever the tree changes */
+	std::vector<Node*> terminals_;
+	std::vector<Node*> nonterminals_;
 };
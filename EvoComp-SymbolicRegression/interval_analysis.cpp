@@ -0,0 +1,258 @@
+/*
+* interval_analysis.cpp
+* UIdaho CS-572: Evolutionary Computation
+* IntervalAnalysis class - bounds what a tree can output over the training
+* inputs without evaluating it on any rows.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "interval_analysis.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "operator_table.h"
+
+static const double kInfinity = std::numeric_limits<double>::infinity();
+
+static Interval MakeInterval(double lo, double hi, bool nan);
+static Interval PointInterval(double value);
+static Interval EndpointHull(const double *values, size_t count, bool nan);
+static bool IsEmpty(const Interval &a);
+static Interval AddIntervals(const Interval &a, const Interval &b);
+static Interval MultiplyIntervals(const Interval &a, const Interval &b);
+static Interval DivideIntervals(const Interval &a, const Interval &b);
+static Interval ApplyUnary(OpType op, const Interval &a);
+
+IntervalAnalysis::IntervalAnalysis() {
+}
+IntervalAnalysis::IntervalAnalysis(const Dataset &data) {
+	size_t rows = data.GetRowCount();
+	columns_.resize(data.GetColumnCount());
+	for (size_t c = 0; c < columns_.size(); ++c) {
+		const double *column = data.GetColumn<double>(c);
+		Interval range = MakeInterval(kInfinity, -kInfinity, false);
+		for (size_t r = 0; r < rows; ++r) {
+			if (std::isnan(column[r])) {
+				range.nan = true;
+			} else {
+				range.lo = std::min(range.lo, column[r]);
+				range.hi = std::max(range.hi, column[r]);
+			}
+		}
+		columns_[c] = range;
+	}
+	const double *targets = data.GetTargets();
+	targets_.assign(targets, targets + rows);
+}
+Interval IntervalAnalysis::Analyze(Node *node) const {
+	switch (node->GetOpType()) {
+	case kConst:
+		return PointInterval(node->GetConstValue());
+	case kVar:
+		if (node->GetVarIndex() >= columns_.size()) {
+			return MakeInterval(-kInfinity, kInfinity, true);
+		}
+		return columns_[node->GetVarIndex()];
+	default:
+		break;
+	}
+
+	OpType op = node->GetOpType();
+	Interval left = Analyze(node->GetLeftChild());
+	if (!node->GetRightChild()) {
+		return ApplyUnary(op, left);
+	}
+	Interval right = Analyze(node->GetRightChild());
+
+	/* Two points give exactly the evaluators' answer */
+	if (left.lo == left.hi && right.lo == right.hi) {
+		Interval out = PointInterval(ApplyOperator(op, left.lo, right.lo));
+		out.nan = out.nan || left.nan || right.nan;
+		return out;
+	}
+	switch (op) {
+	case kAdd:
+		return AddIntervals(left, right);
+	case kSub:
+		return AddIntervals(left, MakeInterval(-right.hi, -right.lo,
+											   right.nan));
+	case kMult:
+		return MultiplyIntervals(left, right);
+	case kDiv:
+		return DivideIntervals(left, right);
+	default:
+		return MakeInterval(-kInfinity, kInfinity, true);
+	}
+}
+OutputShape IntervalAnalysis::Classify(Node *root, double &constant) const {
+	/*
+	 * No numbers at all means NaN on every row, and a lone NaN-free
+	 * point, finite or not, is that value on every row.  A point that
+	 * may also be NaN is left to the evaluators, since one NaN row would
+	 * make the whole error NaN.
+	 */
+	Interval out = Analyze(root);
+	if (IsEmpty(out)) {
+		constant = std::numeric_limits<double>::quiet_NaN();
+		return kNonFiniteOutput;
+	}
+	if (out.lo == out.hi && !out.nan) {
+		constant = out.lo;
+		return std::isinf(constant) ? kNonFiniteOutput : kConstantOutput;
+	}
+	return kVaryingOutput;
+}
+double IntervalAnalysis::ConstantError(double constant,
+									   size_t tile_rows) const {
+	size_t rows = targets_.size();
+	double error = 0;
+	for (size_t begin = 0; begin < rows; begin += tile_rows) {
+		size_t end = std::min(begin + tile_rows, rows);
+		double partial = 0;
+		for (size_t r = begin; r < end; ++r) {
+			double diff = targets_[r] - constant;
+			partial += diff * diff;
+		}
+		error += partial;
+	}
+	return sqrt(error / rows);
+}
+void IntervalAnalysis::ConstantCaseErrors(double constant, float *case_errors,
+										  size_t case_stride) const {
+	/* NaN would never survive lexicase, so it is inf, as when evaluated */
+	for (size_t i = 0; i < targets_.size(); ++i) {
+		float abs_diff = static_cast<float>(std::fabs(targets_[i] - constant));
+		case_errors[i * case_stride] = (abs_diff == abs_diff) ?
+			abs_diff : std::numeric_limits<float>::infinity();
+	}
+}
+
+/* Helper Functions */
+static Interval MakeInterval(double lo, double hi, bool nan) {
+	Interval a;
+	a.lo = lo;
+	a.hi = hi;
+	a.nan = nan;
+	return a;
+}
+static Interval PointInterval(double value) {
+	if (std::isnan(value)) {
+		return MakeInterval(kInfinity, -kInfinity, true);
+	}
+	return MakeInterval(value, value, false);
+}
+static Interval EndpointHull(const double *values, size_t count, bool nan) {
+	/*
+	 * The result of a monotone operation on the corners of the boxes.  A
+	 * NaN corner (inf - inf, 0 * inf, inf / inf) means the operation can
+	 * produce NaN and that nearby finite inputs can produce anything.
+	 */
+	Interval a = MakeInterval(kInfinity, -kInfinity, nan);
+	for (size_t i = 0; i < count; ++i) {
+		if (std::isnan(values[i])) {
+			return MakeInterval(-kInfinity, kInfinity, true);
+		}
+		a.lo = std::min(a.lo, values[i]);
+		a.hi = std::max(a.hi, values[i]);
+	}
+	return a;
+}
+static bool IsEmpty(const Interval &a) {
+	return a.lo > a.hi;
+}
+static Interval AddIntervals(const Interval &a, const Interval &b) {
+	bool nan = a.nan || b.nan;
+	if (IsEmpty(a) || IsEmpty(b)) {
+		return MakeInterval(kInfinity, -kInfinity, nan);
+	}
+	double corners[] = { a.lo + b.lo, a.hi + b.hi, a.lo + b.hi, a.hi + b.lo };
+	return EndpointHull(corners, 4, nan);
+}
+static Interval MultiplyIntervals(const Interval &a, const Interval &b) {
+	bool nan = a.nan || b.nan;
+	if (IsEmpty(a) || IsEmpty(b)) {
+		return MakeInterval(kInfinity, -kInfinity, nan);
+	}
+	/* 0 * inf is NaN even when the zero is inside an interval */
+	bool a_zero = (a.lo <= 0 && a.hi >= 0);
+	bool b_zero = (b.lo <= 0 && b.hi >= 0);
+	bool a_infinite = std::isinf(a.lo) || std::isinf(a.hi);
+	bool b_infinite = std::isinf(b.lo) || std::isinf(b.hi);
+	nan = nan || (a_zero && b_infinite) || (b_zero && a_infinite);
+	double corners[] = { a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi };
+	return EndpointHull(corners, 4, nan);
+}
+static Interval DivideIntervals(const Interval &a, const Interval &b) {
+	/* Protected: a zero divisor divides by one, which leaves a alone */
+	bool nan = a.nan || b.nan;
+	if (IsEmpty(a) || IsEmpty(b)) {
+		return MakeInterval(kInfinity, -kInfinity, nan);
+	}
+	if (b.lo == 0 && b.hi == 0) {
+		return MakeInterval(a.lo, a.hi, nan);
+	}
+	if (b.lo <= 0 && b.hi >= 0) {
+		/* Divisors near zero reach every magnitude */
+		return MakeInterval(-kInfinity, kInfinity,
+			nan || std::isinf(a.lo) || std::isinf(a.hi));
+	}
+	double corners[] = { a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi };
+	return EndpointHull(corners, 4, nan);
+}
+static Interval ApplyUnary(OpType op, const Interval &a) {
+	if (IsEmpty(a)) {
+		return a;
+	}
+	if (a.lo == a.hi) {
+		Interval out = PointInterval(ApplyOperator(op, a.lo, 0.0));
+		out.nan = out.nan || a.nan;
+		return out;
+	}
+
+	/* Range of |x|, for the operators that are even in x */
+	bool has_zero = (a.lo <= 0 && a.hi >= 0);
+	double min_magnitude = has_zero ? 0 :
+		std::min(std::fabs(a.lo), std::fabs(a.hi));
+	double max_magnitude = std::max(std::fabs(a.lo), std::fabs(a.hi));
+
+	switch (op) {
+	case kExp:
+		return MakeInterval(std::exp(a.lo), std::exp(a.hi), a.nan);
+	case kLog:
+		/* log|x|, and 0 at x == 0, which is in range whenever 0 is */
+		if (has_zero) {
+			return MakeInterval(-kInfinity,
+				std::max(0.0, std::log(max_magnitude)), a.nan);
+		}
+		return MakeInterval(std::log(min_magnitude),
+							std::log(max_magnitude), a.nan);
+	case kSqrt:
+		return MakeInterval(std::sqrt(min_magnitude),
+							std::sqrt(max_magnitude), a.nan);
+	case kSquare:
+		return MakeInterval(min_magnitude * min_magnitude,
+							max_magnitude * max_magnitude, a.nan);
+	case kSin:
+	case kCos:
+		/* Infinite inputs give NaN; finite ones somewhere in [-1, 1] */
+		return MakeInterval(-1, 1,
+			a.nan || std::isinf(a.lo) || std::isinf(a.hi));
+	default:
+		return MakeInterval(-kInfinity, kInfinity, true);
+	}
+}
@@ -0,0 +1,78 @@
+/*
+* interval_analysis.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for IntervalAnalysis class - bounds what a tree can output over
+* the training inputs without evaluating it on any rows
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "dataset.h"
+#include "node.h"
+
+/*
+ * Every value a subtree can produce: a subset of [lo, hi] over the
+ * extended reals, plus NaN when nan is set.  lo > hi means no numbers at
+ * all, so only NaN (if anything).
+ */
+struct Interval {
+	double lo;
+	double hi;
+	bool nan;
+};
+
+/* What the analysis can prove about a tree's output on every row */
+enum OutputShape {
+	kVaryingOutput = 0, /* Nothing proven; the tree has to be evaluated */
+	kConstantOutput = 1, /* One finite value on every row */
+	kNonFiniteOutput = 2 /* The same inf, or NaN, on every row */
+};
+
+/*
+ * Propagates the per-column min/max of the data up through a tree.  The
+ * bounds are worked out with the same kernels and the same rounding as
+ * the evaluators, and rounding is monotone, so they bound what the
+ * evaluators actually compute rather than the exact real values.  A
+ * subtree without variables comes out as exactly the value the
+ * evaluators would give it.
+ */
+class IntervalAnalysis {
+public:
+	IntervalAnalysis();
+	explicit IntervalAnalysis(const Dataset &data);
+
+	Interval Analyze(Node *node) const;
+
+	/* constant is the output on every row, unless kVaryingOutput */
+	OutputShape Classify(Node *root, double &constant) const;
+
+	/*
+	 * Root mean squared error of predicting constant on every row, summed
+	 * in tiles of tile_rows as the evaluators do, so it matches theirs
+	 * bit for bit.  The case errors are the evaluators' too.
+	 */
+	double ConstantError(double constant, size_t tile_rows) const;
+	void ConstantCaseErrors(double constant, float *case_errors,
+							size_t case_stride) const;
+private:
+	std::vector<Interval> columns_;
+	std::vector<double> targets_;
+};
@@ -0,0 +1,142 @@
+/*
+* model.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Implementation of Model class - an evolved expression saved to or
+* loaded from a model file so it can score new data outside of a run
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "model.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "number_format.h"
+
+static const char kModelHeader[] = "ec-symbolicreg model 1";
+
+Model::Model() : root_(nullptr), column_count_(0), height_(0) {}
+Model::~Model() {
+	if (root_) {
+		root_->Erase();
+	}
+}
+bool Model::Save(const std::string &filename, Individual &individual,
+				 size_t column_count) {
+	std::string out(kModelHeader);
+	out.append("\ncolumns ");
+	AppendSize(out, column_count);
+	out.append("\nprefix ");
+	individual.Render(out, kPrefix);
+	out.push_back('\n');
+
+	std::ofstream outf(filename, std::ofstream::out | std::ofstream::trunc);
+	if (!outf) {
+		std::cerr << "Failed to open file: " << filename << std::endl;
+		return false;
+	}
+	outf << out;
+	return static_cast<bool>(outf);
+}
+bool Model::Load(const std::string &filename) {
+	std::ifstream inf(filename, std::ifstream::in);
+	std::string header, columns, prefix;
+	if (!inf) {
+		std::cerr << "Failed to open file: " << filename << std::endl;
+		return false;
+	}
+	std::getline(inf, header);
+	std::getline(inf, columns);
+	std::getline(inf, prefix);
+	if (header != kModelHeader || columns.compare(0, 8, "columns ") != 0 ||
+		prefix.compare(0, 7, "prefix ") != 0) {
+		std::cerr << "Not a model file: " << filename << std::endl;
+		return false;
+	}
+
+	if (!Parse(prefix.substr(7),
+			   std::strtoull(columns.c_str() + 8, nullptr, 10))) {
+		std::cerr << "Malformed model expression in: " << filename
+				  << std::endl;
+		return false;
+	}
+	return true;
+}
+bool Model::Parse(const std::string &prefix, size_t column_count) {
+	/*
+	 * Replaces the expression with prefix, in Node::Render(kPrefix) form,
+	 * over column_count input columns.  A malformed prefix leaves the
+	 * model as it was.
+	 */
+	Node *root = new Node;
+	size_t pos = 0;
+	bool ok = root->Parse(prefix, pos, nullptr);
+	if (ok) {
+		/* Anything left over, or a variable past the last column, is bad */
+		ok = prefix.find_first_not_of(' ', pos) == std::string::npos;
+		std::vector<Node*> terminals, nonterminals;
+		root->IndexNodes(terminals, nonterminals);
+		for (auto t : terminals) {
+			if (t->GetOpType() == kVar &&
+				t->GetVarIndex() >= column_count) {
+				ok = false;
+			}
+		}
+	}
+	if (!ok) {
+		root->Erase();
+		return false;
+	}
+	if (root_) {
+		root_->Erase();
+	}
+	root_ = root;
+	column_count_ = column_count;
+	height_ = root_->GetHeight();
+	return true;
+}
+void Model::Predict(const Dataset &data, size_t row_begin, size_t count,
+					double *out) {
+	/*
+	 * Writes the predictions for rows [row_begin, row_begin + count) to
+	 * out.  Safe to call from several threads at once; each keeps its
+	 * own scratch space.
+	 */
+	const size_t kBlockRows = 256;
+	static thread_local std::vector<double> scratch;
+	if (scratch.size() < (height_ + 1) * kBlockRows) {
+		scratch.resize((height_ + 1) * kBlockRows);
+	}
+	for (size_t begin = 0; begin < count; begin += kBlockRows) {
+		size_t block = std::min(kBlockRows, count - begin);
+		double *buffer = scratch.data();
+		const double *result = root_->EvaluateBatch(data, row_begin + begin,
+													block, buffer,
+													buffer + kBlockRows);
+		std::memcpy(out + begin, result, block * sizeof(double));
+	}
+}
+std::string Model::ToString(bool latex) {
+	return root_ ? root_->ToString(latex) : std::string();
+}
+
+/* Private Accessors/Mutators */
+size_t Model::GetColumnCount() {
+	return column_count_;
+}
@@ -0,0 +1,64 @@
+/*
+* model.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for Model class - an evolved expression saved to or loaded from
+* a model file so it can score new data outside of a run
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "dataset.h"
+#include "individual.h"
+#include "node.h"
+
+/*
+ * A model file is plain text:
+ *
+ *   ec-symbolicreg model 1
+ *   columns <input columns the expression was trained on>
+ *   prefix <expression in Node::Render(kPrefix) form>
+ *
+ * Constants are written with the fewest digits that read back exactly,
+ * so a saved model predicts bit for bit what the individual did.
+ */
+class Model {
+public:
+	Model();
+	~Model();
+
+	static bool Save(const std::string &filename, Individual &individual,
+					 size_t column_count);
+	bool Load(const std::string &filename);
+	bool Parse(const std::string &prefix, size_t column_count);
+	void Predict(const Dataset &data, size_t row_begin, size_t count,
+				 double *out);
+	std::string ToString(bool latex = false);
+
+	/* Private Accessors/Mutators */
+	size_t GetColumnCount();
+private:
+	Model(const Model &) = delete;
+	Model& operator=(const Model &) = delete;
+
+	Node *root_;
+	size_t column_count_;
+	size_t height_;
+};
@@ -21,36 +21,38 @@
 * along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "node.h"
-#include <deque>
+#include <algorithm> /* For std::fill */
+#include <cstdlib> /* For std::strtod */
+#include <cstring> /* For std::memcpy */
 #include <iostream> /* Only for errors */
 #include <random>
-#include <string> /* For std::to_string */
+#include <string>
+#include "number_format.h"
+#include "operator_table.h"
 #include "operator_types.h"
+#include "subtree_cache.h"
 
 void Node::Copy(Node *to_copy) {
 	parent_ = to_copy->parent_;
 	op_ = to_copy->op_;
-	var_count_ = to_copy->var_count_;
-	const_min_ = to_copy->const_min_;
-	const_max_ = to_copy->const_max_;
+	left_ = nullptr;
+	right_ = nullptr;
 
 	switch (op_) {
 	case kConst:
 		const_val_ = to_copy->const_val_;
-		left_ = nullptr;
-		right_ = nullptr;
 		break;
 	case kVar:
-		left_ = nullptr;
-		right_ = nullptr;
 		var_index_ = to_copy->var_index_;
 		break;
 	default:
-		/* Leaf node, so copy children */
+		/* Nonterminal, so copy however many children it has */
 		left_ = new Node;
-		right_ = new Node;
 		left_->Copy(to_copy->left_);
-		right_->Copy(to_copy->right_);
+		if (to_copy->right_) {
+			right_ = new Node;
+			right_->Copy(to_copy->right_);
+		}
 	}
 }
 void Node::Erase() {
@@ -63,247 +65,647 @@ void Node::Erase() {
 	delete this;
 }
 std::string Node::ToString(bool latex) {
+	std::string out;
+	Render(out, latex ? kLatex : kInfix);
+	return out;
+}
+void Node::Render(std::string &out, RenderFormat format) {
+	/* Appends to out so a whole tree only ever touches one buffer */
 	switch (op_) {
-	case kAdd:
-		return left_->ToString(latex) + " + " + right_->ToString(latex);
-		break;
-	case kSub:
-		return left_->ToString(latex) + " - " + right_->ToString(latex);
-		break;
-	case kMult:
-		return("(" + left_->ToString(latex) + 
-			   ")(" + right_->ToString(latex) + ")");
-		break;
-	case kDiv:
-		if (latex) {
-			return("\\frac{" + left_->ToString(latex) +
-				   "}{" + right_->ToString(latex) + "}");
-		} else {
-			return ("(" + left_->ToString(latex) +
-					" / " + right_->ToString(latex) + ")");
-		}
-		break;
 	case kConst:
-		return std::to_string(const_val_);
-		break;
+		AppendDouble(out, const_val_);
+		return;
 	case kVar:
-		return "X_" + std::to_string(var_index_);
-		break;
+		out.append("X_");
+		AppendSize(out, var_index_);
+		return;
 	default:
-		return "ERROR REACHED";
 		break;
 	}
-}
-void Node::GenerateTree(size_t cur_depth, size_t max_depth,
-						Node *parent, bool full_tree) {
-	std::random_device rd;
-	std::mt19937 mt(rd());
 
-	OpType lower_bound, upper_bound;
+	const OperatorInfo &info = GetOperatorInfo(op_);
+	if (format == kPrefix) {
+		out.append(info.name);
+		out.push_back(' ');
+		left_->Render(out, format);
+		if (right_) {
+			out.push_back(' ');
+			right_->Render(out, format);
+		}
+		return;
+	}
+
+	const char *const *printer = (format == kLatex) ? info.latex : info.infix;
+	out.append(printer[0]);
+	left_->Render(out, format);
+	if (right_) {
+		out.append(printer[1]);
+		right_->Render(out, format);
+	}
+	out.append(printer[2]);
+}
+bool Node::Parse(const std::string &prefix, size_t &pos, Node *parent) {
+	/*
+	 * Reads a subtree written by Render(kPrefix) starting at prefix[pos]
+	 * and leaves pos just past it.  Returns false on malformed input; the
+	 * partial subtree is still well formed, so the caller can simply
+	 * Erase it.
+	 */
 	parent_ = parent;
+	left_ = nullptr;
+	right_ = nullptr;
+	while (pos < prefix.size() && prefix[pos] == ' ') {
+		++pos;
+	}
+	size_t end = prefix.find(' ', pos);
+	if (end == std::string::npos) {
+		end = prefix.size();
+	}
+	if (end == pos) {
+		return false;
+	}
+	std::string token = prefix.substr(pos, end - pos);
+	pos = end;
 
-	if (full_tree) {
-		lower_bound = kAdd;
-		upper_bound = kDiv;
-	} else {
-		lower_bound = kAdd;
-		upper_bound = kVar;
+	if (token.size() > 2 && token[0] == 'X' && token[1] == '_') {
+		char *stop = nullptr;
+		op_ = kVar;
+		var_index_ = static_cast<size_t>(
+			std::strtoull(token.c_str() + 2, &stop, 10));
+		return *stop == '\0';
+	}
+	op_ = FindOperator(token.c_str(), token.size());
+	if (op_ == kConst) {
+		char *stop = nullptr;
+		const_val_ = std::strtod(token.c_str(), &stop);
+		return *stop == '\0';
 	}
+	for (size_t i = 0; i < GetArity(op_); ++i) {
+		Node *child = new Node;
+		bool ok = child->Parse(prefix, pos, this);
+		if (!i) {
+			left_ = child;
+		} else {
+			right_ = child;
+		}
+		if (!ok) {
+			return false;
+		}
+	}
+	return true;
+}
+uint64_t Node::Hash() {
+	/* Structural hash of this subtree; equal trees hash equally */
+	uint64_t left_hash = 0;
+	uint64_t right_hash = 0;
+	if (IsNonTerminal()) {
+		left_hash = left_->Hash();
+		if (right_) {
+			right_hash = right_->Hash();
+		}
+	}
+	return CombineHash(left_hash, right_hash);
+}
+uint64_t Node::HashNodes(std::vector<uint64_t> &hashes,
+						 std::vector<uint64_t> &checks,
+						 std::vector<size_t> &sizes) {
+	/*
+	 * Appends the Hash, a second independent hash and the node count of
+	 * every subtree, in preorder, in one pass rather than one Hash call
+	 * per node.  Returns Hash().
+	 */
+	size_t pos = hashes.size();
+	hashes.push_back(0);
+	checks.push_back(0);
+	sizes.push_back(1);
+	uint64_t left_hash = 0;
+	uint64_t right_hash = 0;
+	uint64_t left_check = 0;
+	uint64_t right_check = 0;
+	if (IsNonTerminal()) {
+		left_hash = left_->HashNodes(hashes, checks, sizes);
+		left_check = checks[pos + 1];
+		if (right_) {
+			size_t right_pos = sizes.size();
+			right_hash = right_->HashNodes(hashes, checks, sizes);
+			right_check = checks[right_pos];
+		}
+		sizes[pos] = sizes.size() - pos;
+	}
+	hashes[pos] = CombineHash(left_hash, right_hash);
+	checks[pos] = CombineCheck(left_check, right_check);
+	return hashes[pos];
+}
+void Node::GenerateTree(size_t cur_depth, size_t max_depth,
+						Node *parent, bool full_tree,
+						const NodeContext &context,
+						const OperatorSet &operators, std::mt19937 &mt) {
+	parent_ = parent;
+	left_ = nullptr;
+	right_ = nullptr;
+
 	if (cur_depth >= max_depth) {
-		lower_bound = kConst;
-		upper_bound = kVar;
+		std::uniform_int_distribution<int> d{ kConst, kVar };
+		op_ = static_cast<OpType>(d(mt));
+	} else if (full_tree) {
+		op_ = operators.GetRandomFunction(mt);
+	} else {
+		/* Grow: every function and both terminal kinds are equally likely */
+		size_t function_count = operators.GetFunctionCount();
+		std::uniform_int_distribution<size_t> d{ 0,function_count + 1 };
+		size_t pick = d(mt);
+		if (pick < function_count) {
+			op_ = operators.GetFunction(pick);
+		} else {
+			op_ = (pick == function_count) ? kConst : kVar;
+		}
 	}
 
-	std::uniform_int_distribution<int> d{ lower_bound, upper_bound };
-	op_ = static_cast<OpType>(d(mt));
 	switch (op_) {
-	case kAdd:
-	case kSub:
-	case kMult:
-	case kDiv:
-		for (size_t i = 0; i < 2; ++i) {
+	case kConst:
+		const_val_ = context.GenerateConstantValue(mt);
+		break;
+	case kVar:
+		var_index_ = context.GenerateVariableIndex(mt);
+		break;
+	default:
+		for (size_t i = 0; i < GetArity(op_); ++i) {
 			Node *child = new Node;
 			if (!i) {
 				left_ = child;
 			} else {
 				right_ = child;
 			}
-			child->var_count_ = this->var_count_;
-			child->const_min_ = this->const_min_;
-			child->const_max_ = this->const_max_;
-			child->GenerateTree(cur_depth + 1, max_depth, this, full_tree);
+			child->GenerateTree(cur_depth + 1, max_depth, this, full_tree,
+								context, operators, mt);
 		}
 		break;
-	case kConst:
-		const_val_ = GenerateConstantValue();
-		left_ = nullptr;
-		right_ = nullptr;
-		break;
-	case kVar:
-		var_index_ = GenerateVariableIndex();
-		left_ = nullptr;
-		right_ = nullptr;
-		break;
-	default:
-		/* Shouldn't get here */
-		std::cerr << "Bad node type!" << std::endl;
-		exit(EXIT_FAILURE);
-		break;
 	}
 }
-void Node::Mutate(double mutation_chance) {
-	std::random_device rd;
-	std::mt19937 mt(rd());
-	std::uniform_real_distribution<double> mut_dist{ 0,1 };
-	
-	
-	if (mut_dist(mt) <= mutation_chance) {
-		OpType lower_bound, upper_bound;
-		if (IsTerminal()) {
-			lower_bound = kConst;
-			upper_bound = kVar;
+void Node::GenerateTreePTC2(size_t target_size, size_t max_depth,
+							const NodeContext &context,
+							const OperatorSet &operators, std::mt19937 &mt) {
+	/*
+	 * PTC2 (Luke, 2000): expands a randomly chosen open function at a
+	 * time, making each new child a function while the nodes made plus
+	 * the children still owed stay under target_size, and a terminal
+	 * once they do not.  The result has target_size nodes, give or take
+	 * the largest arity.  Slots at max_depth only ever get terminals.
+	 */
+	std::vector<std::pair<Node*, size_t>> open; /* Slot and its depth */
+	std::uniform_int_distribution<int> terminal{ kConst, kVar };
+	size_t size = 1;
+	size_t promised = 0; /* Children still owed to the open functions */
+
+	parent_ = nullptr;
+	left_ = nullptr;
+	right_ = nullptr;
+	if (target_size <= 1 || max_depth == 0) {
+		op_ = static_cast<OpType>(terminal(mt));
+	} else {
+		op_ = operators.GetRandomFunction(mt);
+		open.push_back(std::make_pair(this, 0));
+		promised = GetArity(op_);
+	}
+
+	std::vector<Node*> leaves;
+	while (!open.empty()) {
+		std::uniform_int_distribution<size_t> d{ 0,open.size() - 1 };
+		size_t pick = d(mt);
+		std::pair<Node*, size_t> slot = open[pick];
+		open[pick] = open.back();
+		open.pop_back();
+
+		Node *node = slot.first;
+		size_t arity = GetArity(node->op_);
+		promised -= arity;
+		for (size_t i = 0; i < arity; ++i) {
+			Node *child = new Node;
+			child->parent_ = node;
+			child->left_ = nullptr;
+			child->right_ = nullptr;
+			if (!i) {
+				node->left_ = child;
+			} else {
+				node->right_ = child;
+			}
+			++size;
+
+			/* Siblings yet to be made count as promised too */
+			if (size + promised + (arity - i - 1) < target_size &&
+				slot.second + 1 < max_depth) {
+				child->op_ = operators.GetRandomFunction(mt);
+				open.push_back(std::make_pair(child, slot.second + 1));
+				promised += GetArity(child->op_);
+			} else {
+				child->op_ = static_cast<OpType>(terminal(mt));
+				leaves.push_back(child);
+			}
+		}
+	}
+	if (IsTerminal()) {
+		leaves.push_back(this);
+	}
+	for (auto leaf : leaves) {
+		if (leaf->op_ == kConst) {
+			leaf->const_val_ = context.GenerateConstantValue(mt);
 		} else {
-			lower_bound = kAdd;
-			upper_bound = kDiv;
+			leaf->var_index_ = context.GenerateVariableIndex(mt);
 		}
-		std::uniform_int_distribution<int> d{ lower_bound, upper_bound };
-		
+	}
+}
+void Node::Mutate(const NodeContext &context, const OperatorSet &operators,
+				  std::mt19937 &mt) {
+	/* Mutates this node only; Individual::Mutate picks which nodes */
+	if (IsTerminal()) {
+		std::uniform_int_distribution<int> d{ kConst, kVar };
 		op_ = static_cast<OpType>(d(mt));
 		switch (op_) {
 		case kConst:
-			const_val_ = GenerateConstantValue();
+			const_val_ = context.GenerateConstantValue(mt);
 			break;
 		case kVar:
-			var_index_ = GenerateVariableIndex();
+			var_index_ = context.GenerateVariableIndex(mt);
+			break;
+		default:
+			break;
+		}
+	} else {
+		/* Stay within the same arity so the children still fit */
+		OpType op = operators.GetRandomFunction(GetArity(op_), mt);
+		if (op != kConst) {
+			op_ = op;
 		}
-	}
-	if (IsNonTerminal()) {
-		left_->Mutate(mutation_chance);
-		right_->Mutate(mutation_chance);
 	}
 }
-double Node::Evaluate(std::vector<double> var_values) {
-	double right_fitness;
+double Node::Evaluate(const std::vector<double> &var_values) {
 	switch (op_) {
-	case kAdd:
-		return left_->Evaluate(var_values) + right_->Evaluate(var_values);
-		break;
-	case kSub:
-		return left_->Evaluate(var_values) - right_->Evaluate(var_values);
-		break;
-	case kMult:
-		return left_->Evaluate(var_values) * right_->Evaluate(var_values);
-		break;
-	case kDiv:
-		right_fitness = right_->Evaluate(var_values);
-		if (right_fitness == 0) {
-			right_fitness = 1; /* Safe Division */
-		}
-		return left_->Evaluate(var_values) / right_fitness;
-		break;
 	case kConst:
 		return const_val_;
-		break;
 	case kVar:
 		return var_values[var_index_]; /* No bounds checking here */
-		break;
 	default:
-		std::cerr << "Node has no OpType!" << std::endl;
-		exit(EXIT_FAILURE);
-		break;
+		return ApplyOperator(op_, left_->Evaluate(var_values),
+							 right_ ? right_->Evaluate(var_values) : 0);
 	}
 }
-std::pair<Node*, bool> Node::SelectNode(size_t countdown, bool nonterminal) {
-	std::deque<std::pair<Node*, bool>> stack;
-	std::pair<Node*, bool> current;
-	bool done = false;
-
-	stack.push_front(std::make_pair(this, true));
-
-	while (!done) {
-		if (stack.empty()) {
-			std::cerr << "Empty stack!" << std::endl;
-			exit(EXIT_FAILURE);
-		}
-		if (countdown == SIZE_MAX) {
-			std::cerr << "Countdown wrapped around!" << std::endl;
-			exit(EXIT_FAILURE);
-		}
-		current = stack.front();
-		stack.pop_front();
-		if (countdown == 0 && nonterminal == current.first->IsNonTerminal()) {
-			/* Found the node that we want. */
-			done = true;
-			return current;
-			break;
-		}
-		if (nonterminal == current.first->IsNonTerminal()) {
-			--countdown;
-		}
-		
-		if (current.first->right_) {
-			stack.push_front(std::make_pair(current.first->right_, false));
+template <typename T>
+const T* Node::EvaluateBatch(const Dataset &data, size_t row_begin,
+							 size_t count, T *out, T *scratch) {
+	/*
+	 * Evaluates rows [row_begin, row_begin + count) and returns where the
+	 * results are: a variable returns its own column, anything else is
+	 * written to out.  The right subtree evaluates into scratch and uses
+	 * the rest of it for its own children, so scratch needs room for
+	 * GetHeight() blocks of count values.  T is double or float; the
+	 * float version needs Dataset::BuildSinglePrecision first.
+	 */
+	switch (op_) {
+	case kConst:
+		std::fill(out, out + count, static_cast<T>(const_val_));
+		return out;
+	case kVar:
+		return data.GetColumn<T>(var_index_) + row_begin;
+	default: {
+		const T *left = left_->EvaluateBatch(data, row_begin, count,
+											 out, scratch);
+		const T *right = nullptr;
+		if (right_) {
+			right = right_->EvaluateBatch(data, row_begin, count,
+										  scratch, scratch + count);
 		}
-		if (current.first->left_) {
-			stack.push_front(std::make_pair(current.first->left_, true));
+		ApplyOperatorBatch(op_, left, right, out, count);
+		return out;
+	}
+	}
+}
+template const double* Node::EvaluateBatch<double>(const Dataset&, size_t,
+	size_t, double*, double*);
+template const float* Node::EvaluateBatch<float>(const Dataset&, size_t,
+	size_t, float*, float*);
+const double* Node::EvaluateCached(const Dataset &data, size_t row_begin,
+								   size_t count, double *out, double *scratch,
+								   SubtreeCache &cache, const uint64_t *hashes,
+								   const uint64_t *checks, const size_t *sizes,
+								   size_t pos) {
+	/*
+	 * EvaluateBatch in double, except that a subtree found in cache is
+	 * not evaluated at all and one that is not is added once it is.
+	 * hashes, checks and sizes come from HashNodes on the root, and pos
+	 * is this node's preorder position in them.  The root is left out,
+	 * since only an identical tree could ever use its column.
+	 */
+	if (IsTerminal()) {
+		return EvaluateBatch(data, row_begin, count, out, scratch);
+	}
+	bool cacheable = (pos && sizes[pos] >= SubtreeCache::kMinNodes);
+	if (cacheable) {
+		const double *cached = cache.Find(hashes[pos], checks[pos],
+										  sizes[pos], row_begin, count);
+		if (cached) {
+			return cached;
 		}
 	}
-	return current;
+	const double *left = left_->EvaluateCached(data, row_begin, count, out,
+		scratch, cache, hashes, checks, sizes, pos + 1);
+	const double *right = nullptr;
+	if (right_) {
+		right = right_->EvaluateCached(data, row_begin, count, scratch,
+			scratch + count, cache, hashes, checks, sizes,
+			pos + 1 + sizes[pos + 1]);
+	}
+	ApplyOperatorBatch(op_, left, right, out, count);
+	if (cacheable) {
+		cache.Insert(hashes[pos], checks[pos], sizes[pos], row_begin, count,
+					 out);
+	}
+	return out;
 }
+double Node::EvaluateTape(const std::vector<double> &var_values,
+						  std::vector<double> &tape) {
+	/*
+	 * Evaluates like Evaluate, but also appends the local partial
+	 * derivative with respect to each child of every nonterminal to tape
+	 * in preorder, for a later reverse-mode pass through Backpropagate.
+	 */
+	if (IsTerminal()) {
+		return Evaluate(var_values);
+	}
+	size_t slot = tape.size();
+	tape.resize(slot + GetArity(op_));
+	double left = left_->EvaluateTape(var_values, tape);
+	double right = right_ ? right_->EvaluateTape(var_values, tape) : 0;
 
-/* Helper Functions */
-void Node::CountNodes(size_t &term_count, size_t &nonterm_count) {
+	double left_partial, right_partial;
+	OperatorPartials(op_, left, right, left_partial, right_partial);
+	tape[slot] = left_partial;
+	if (right_) {
+		tape[slot + 1] = right_partial;
+	}
+	return ApplyOperator(op_, left, right);
+}
+void Node::Backpropagate(const double *tape, size_t &tape_pos,
+						 double adjoint, double *const_gradient,
+						 size_t &const_pos) {
+	/*
+	 * Walks the tree in the same preorder as EvaluateTape, adding
+	 * adjoint * d(root)/d(const) for each constant, in preorder, into
+	 * const_gradient.
+	 */
 	switch (op_) {
-	case kAdd:
-	case kSub:
-	case kMult:
-	case kDiv:
-		++nonterm_count;
-		left_->CountNodes(term_count, nonterm_count);
-		right_->CountNodes(term_count, nonterm_count);
-		break;
 	case kConst:
+		const_gradient[const_pos++] += adjoint;
+		break;
 	case kVar:
-		++term_count;
+		break;
+	default: {
+		double left_partial = tape[tape_pos];
+		double right_partial = right_ ? tape[tape_pos + 1] : 0;
+		tape_pos += GetArity(op_);
+		left_->Backpropagate(tape, tape_pos, adjoint * left_partial,
+							 const_gradient, const_pos);
+		if (right_) {
+			right_->Backpropagate(tape, tape_pos, adjoint * right_partial,
+								  const_gradient, const_pos);
+		}
 		break;
 	}
+	}
 }
-double Node::GenerateConstantValue() {
-	std::random_device rd;
-	std::mt19937 mt(rd());
-
-	std::uniform_real_distribution<double> d{ const_min_,const_max_ };
-	return d(mt);
-}
-size_t Node::GenerateVariableIndex() {
-	std::random_device rd;
-	std::mt19937 mt(rd());
+void Node::Simplify() {
+	/*
+	 * Folds constant subtrees and removes algebraic identities in place.
+	 * Every rewrite gives the same value as Evaluate for finite inputs,
+	 * including protected division (x / 0 is x, so x / x is NOT 1).  The
+	 * x - x and 0 * x rewrites only differ when x evaluates to inf/NaN.
+	 */
+	if (IsTerminal()) {
+		return;
+	}
+	left_->Simplify();
+	if (right_) {
+		right_->Simplify();
+	}
 
-	std::uniform_int_distribution<size_t> d{ 0,var_count_ };
-	return d(mt);
-}
-bool Node::IsNonTerminal() {
+	if (left_->op_ == kConst && (!right_ || right_->op_ == kConst)) {
+		MakeConstant(ApplyOperator(op_, left_->const_val_,
+								   right_ ? right_->const_val_ : 0));
+		return;
+	}
 	switch (op_) {
 	case kAdd:
+		if (left_->IsConstant(0)) {
+			ReplaceWithChild(right_);
+		} else if (right_->IsConstant(0)) {
+			ReplaceWithChild(left_);
+		}
+		break;
 	case kSub:
+		if (right_->IsConstant(0)) {
+			ReplaceWithChild(left_);
+		} else if (left_->IsEqual(right_)) {
+			MakeConstant(0);
+		}
+		break;
 	case kMult:
+		if (left_->IsConstant(0) || right_->IsConstant(0)) {
+			MakeConstant(0);
+		} else if (left_->IsConstant(1)) {
+			ReplaceWithChild(right_);
+		} else if (right_->IsConstant(1)) {
+			ReplaceWithChild(left_);
+		}
+		break;
 	case kDiv:
-		return true;
+		if (right_->IsConstant(0) || right_->IsConstant(1)) {
+			ReplaceWithChild(left_); /* Safe Division makes x / 0 == x */
+		} else if (left_->IsConstant(0)) {
+			MakeConstant(0);
+		}
+		break;
+	default:
+		break;
+	}
+}
+/* Helper Functions */
+void Node::CountNodes(size_t &term_count, size_t &nonterm_count) {
+	if (IsTerminal()) {
+		++term_count;
+		return;
+	}
+	++nonterm_count;
+	left_->CountNodes(term_count, nonterm_count);
+	if (right_) {
+		right_->CountNodes(term_count, nonterm_count);
+	}
+}
+void Node::IndexNodes(std::vector<Node*> &terminals,
+					  std::vector<Node*> &nonterminals) {
+	/* Appends every node of the subtree, in preorder, to its own table */
+	if (IsNonTerminal()) {
+		nonterminals.push_back(this);
+		left_->IndexNodes(terminals, nonterminals);
+		if (right_) {
+			right_->IndexNodes(terminals, nonterminals);
+		}
+	} else {
+		terminals.push_back(this);
+	}
+}
+size_t Node::GetSubtreeSize() {
+	size_t term_count = 0;
+	size_t nonterm_count = 0;
+	CountNodes(term_count, nonterm_count);
+	return term_count + nonterm_count;
+}
+size_t Node::GetHeight() {
+	/* Longest path to a leaf; a lone terminal has height 0 */
+	if (IsTerminal()) {
+		return 0;
 	}
-	return false;
+	size_t left_height = left_->GetHeight();
+	size_t right_height = right_ ? right_->GetHeight() : 0;
+	return 1 + (left_height > right_height ? left_height : right_height);
+}
+size_t Node::GetDepth() {
+	/* Distance from the root; the root has depth 0 */
+	size_t depth = 0;
+	for (Node *cur = parent_; cur; cur = cur->parent_) {
+		++depth;
+	}
+	return depth;
+}
+bool Node::IsNonTerminal() {
+	return op_ != kConst && op_ != kVar;
 }
 bool Node::IsTerminal() {
 	return !IsNonTerminal();
 }
+bool Node::IsEqual(Node *other) {
+	/* Structural equality of two subtrees */
+	if (op_ != other->op_) {
+		return false;
+	}
+	switch (op_) {
+	case kConst:
+		return const_val_ == other->const_val_;
+	case kVar:
+		return var_index_ == other->var_index_;
+	default:
+		return left_->IsEqual(other->left_) &&
+			(!right_ || right_->IsEqual(other->right_));
+	}
+}
+uint64_t Node::CombineHash(uint64_t left_hash, uint64_t right_hash) {
+	/* This node's hash from its children's; a leaf hashes its value */
+	uint64_t h = static_cast<uint64_t>(op_);
+	uint64_t value = left_hash;
+
+	switch (op_) {
+	case kConst:
+		std::memcpy(&value, &const_val_, sizeof(value));
+		break;
+	case kVar:
+		value = static_cast<uint64_t>(var_index_);
+		break;
+	default:
+		if (right_) {
+			h ^= value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+			value = right_hash;
+		}
+		break;
+	}
+	h ^= value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	return h;
+}
+uint64_t Node::CombineCheck(uint64_t left_check, uint64_t right_check) {
+	/*
+	 * Like CombineHash, but every step goes through a 64-bit finalizer
+	 * (MurmurHash3's), so subtrees that collide in one are not expected
+	 * to collide in the other
+	 */
+	auto mix = [](uint64_t x) {
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdULL;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53ULL;
+		x ^= x >> 33;
+		return x;
+	};
+	uint64_t h = mix(static_cast<uint64_t>(op_) + 1);
+	switch (op_) {
+	case kConst: {
+		uint64_t bits;
+		std::memcpy(&bits, &const_val_, sizeof(bits));
+		return mix(h ^ bits);
+	}
+	case kVar:
+		return mix(h ^ static_cast<uint64_t>(var_index_));
+	default:
+		return mix(mix(h ^ left_check) ^ right_check);
+	}
+}
+bool Node::IsConstant(double value) {
+	return op_ == kConst && const_val_ == value;
+}
+void Node::MakeConstant(double value) {
+	if (left_) {
+		left_->Erase();
+	}
+	if (right_) {
+		right_->Erase();
+	}
+	left_ = nullptr;
+	right_ = nullptr;
+	op_ = kConst;
+	const_val_ = value;
+}
+void Node::ReplaceWithChild(Node *child) {
+	/* This node takes over child's contents; the other child is erased */
+	Node *other = (child == left_) ? right_ : left_;
+	if (other) {
+		other->Erase();
+	}
+
+	op_ = child->op_;
+	if (op_ == kConst) {
+		const_val_ = child->const_val_;
+	} else if (op_ == kVar) {
+		var_index_ = child->var_index_;
+	}
+	left_ = child->left_;
+	right_ = child->right_;
+	if (left_) {
+		left_->parent_ = this;
+	}
+	if (right_) {
+		right_->parent_ = this;
+	}
+	delete child;
+}
 void Node::CorrectParents(Node *parent) {
 	this->parent_ = parent;
 	if (IsNonTerminal()) {
 		this->left_->CorrectParents(this);
-		this->right_->CorrectParents(this);
+		if (this->right_) {
+			this->right_->CorrectParents(this);
+		}
 	}
 }
 
 /* Private Accessors/Mutators */
+OpType Node::GetOpType() {
+	return op_;
+}
+double Node::GetConstValue() {
+	return const_val_;
+}
+size_t Node::GetVarIndex() {
+	return var_index_;
+}
+void Node::SetConstValue(double const_val) {
+	const_val_ = const_val;
+}
 Node* Node::GetParent() {
 	return parent_;
 }
@@ -317,23 +719,8 @@ void Node::SetParent(Node *parent) {
 	parent_ = parent;
 }
 void Node::SetLeftChild(Node *child) {
-	if (!left_) {
-		left_ = new Node;
-	}
 	left_ = child;
 }
 void Node::SetRightChild(Node *child) {
-	if (!right_) {
-		right_ = new Node;
-	}
 	right_ = child;
 }
-void Node::SetVarCount(size_t var_count) {
-	var_count_ = var_count;
-}
-void Node::SetConstMin(double const_min) {
-	const_min_ = const_min;
-}
-void Node::SetConstMax(double const_max) {
-	const_max_ = const_max;
-}
@@ -22,55 +22,99 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <random>
+#include <string>
 #include <utility> /* std::pair */
 #include <vector>
+#include "dataset.h"
+#include "node_context.h"
+#include "operator_set.h"
 #include "operator_types.h"
+#include "render_format.h"
+
+class SubtreeCache;
 
 class Node {
 public:
 	void Copy(Node *to_copy);
 	void Erase();
 	std::string ToString(bool latex = false);
+	void Render(std::string &out, RenderFormat format);
+	bool Parse(const std::string &prefix, size_t &pos, Node *parent);
+	uint64_t Hash();
+	uint64_t HashNodes(std::vector<uint64_t> &hashes,
+					   std::vector<uint64_t> &checks,
+					   std::vector<size_t> &sizes);
 
 	void GenerateTree(size_t cur_depth, size_t max_depth,
-		Node *parent, bool full_tree);
-	void Mutate(double mutation_chance);
-	double Evaluate(std::vector<double> var_values);
-	std::pair<Node*,bool> SelectNode(size_t countdown, bool nonterminal);
+		Node *parent, bool full_tree, const NodeContext &context,
+		const OperatorSet &operators, std::mt19937 &mt);
+	void GenerateTreePTC2(size_t target_size, size_t max_depth,
+						  const NodeContext &context,
+						  const OperatorSet &operators, std::mt19937 &mt);
+	void Mutate(const NodeContext &context, const OperatorSet &operators,
+				std::mt19937 &mt);
+	double Evaluate(const std::vector<double> &var_values);
+	template <typename T>
+	const T* EvaluateBatch(const Dataset &data, size_t row_begin,
+						   size_t count, T *out, T *scratch);
+	const double* EvaluateCached(const Dataset &data, size_t row_begin,
+								 size_t count, double *out, double *scratch,
+								 SubtreeCache &cache, const uint64_t *hashes,
+								 const uint64_t *checks, const size_t *sizes,
+								 size_t pos);
+	double EvaluateTape(const std::vector<double> &var_values,
+						std::vector<double> &tape);
+	void Backpropagate(const double *tape, size_t &tape_pos, double adjoint,
+					   double *const_gradient, size_t &const_pos);
+	void Simplify();
 
 	/* Public Helper Functions */
 	void CountNodes(size_t &term_count, size_t &nonterm_count);
+	void IndexNodes(std::vector<Node*> &terminals,
+					std::vector<Node*> &nonterminals);
+	size_t GetSubtreeSize();
+	size_t GetHeight();
+	size_t GetDepth();
 	bool IsTerminal();
 	bool IsNonTerminal();
+	bool IsEqual(Node *other);
 	void CorrectParents(Node *parent);
 
 	/* Private Accessors/Mutators */
+	OpType GetOpType();
+	double GetConstValue();
+	size_t GetVarIndex();
+	void SetConstValue(double const_val);
 	Node* GetParent();
 	Node* GetLeftChild();
 	Node* GetRightChild();
 	void SetParent(Node *parent);
 	void SetLeftChild(Node *child);
 	void SetRightChild(Node *child);
-	void SetVarCount(size_t var_count);
-	void SetConstMin(double const_min);
-	void SetConstMax(double const_max);
 private:
 	/* Private Helper Functions */
-	double GenerateConstantValue();
-	size_t GenerateVariableIndex();
+	uint64_t CombineHash(uint64_t left_hash, uint64_t right_hash);
+	uint64_t CombineCheck(uint64_t left_check, uint64_t right_check);
+	bool IsConstant(double value);
+	void MakeConstant(double value);
+	void ReplaceWithChild(Node *child);
 
-	/* Tree Structure */
+	/* Tree Structure; unary functions only have a left child */
 	Node *parent_;
 	Node *left_;
 	Node *right_;
 
-	/* Node Data */
+	/*
+	 * Node Data; a node is a constant, a variable or a function, never
+	 * two at once, so the constant and the variable index share storage
+	 * and op_ says which one is live.  On 64-bit builds a node is three
+	 * pointers, the union and op_ padded out: five words, 40 bytes.
+	 */
+	union {
+		double const_val_;
+		size_t var_index_;
+	};
 	OpType op_;
-	size_t var_index_;
-	double const_val_;
-
-	/* Node Metadata */
-	size_t var_count_;
-	double const_min_;
-	double const_max_;
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+/*
+* node_context.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Implementation of NodeContext class
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "node_context.h"
+
+NodeContext::NodeContext() : NodeContext(0, 0, 0) {}
+NodeContext::NodeContext(size_t var_count, double const_min,
+						 double const_max) {
+	var_count_ = var_count;
+	const_min_ = const_min;
+	const_max_ = const_max;
+}
+double NodeContext::GenerateConstantValue(std::mt19937 &mt) const {
+	std::uniform_real_distribution<double> d{ const_min_,const_max_ };
+	return d(mt);
+}
+size_t NodeContext::GenerateVariableIndex(std::mt19937 &mt) const {
+	std::uniform_int_distribution<size_t> d{ 0,var_count_ };
+	return d(mt);
+}
+
+/* Private Accessors */
+size_t NodeContext::GetVarCount() const {
+	return var_count_;
+}
+double NodeContext::GetConstMin() const {
+	return const_min_;
+}
+double NodeContext::GetConstMax() const {
+	return const_max_;
+}
@@ -0,0 +1,51 @@
+/*
+* node_context.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for NodeContext class - the per-problem settings shared by
+* every node of every tree
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <random>
+
+/*
+ * How many input variables there are and the range new constants are
+ * drawn from.  One context is shared by a whole population; nodes take
+ * it as an argument wherever they make new terminals rather than each
+ * carrying a copy.
+ */
+class NodeContext {
+public:
+	NodeContext();
+	NodeContext(size_t var_count, double const_min, double const_max);
+
+	double GenerateConstantValue(std::mt19937 &mt) const;
+	size_t GenerateVariableIndex(std::mt19937 &mt) const;
+
+	/* Private Accessors */
+	size_t GetVarCount() const;
+	double GetConstMin() const;
+	double GetConstMax() const;
+private:
+	size_t var_count_;
+	double const_min_;
+	double const_max_;
+};
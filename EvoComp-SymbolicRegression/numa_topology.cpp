@@ -0,0 +1,168 @@
+/*
+* numa_topology.cpp
+* UIdaho CS-572: Evolutionary Computation
+* NumaTopology class - finds the machine's NUMA nodes and pins threads
+* to them.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "numa_topology.h"
+#include <thread>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <cstdlib> /* For std::strtoull */
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__linux__)
+static std::vector<size_t> ParseList(const std::string &list);
+#endif
+
+/* The node each thread was last pinned to */
+static thread_local size_t current_node = NumaTopology::kNoNode;
+
+NumaTopology::NumaTopology() {
+	Detect();
+	if (nodes_.empty()) {
+		nodes_.push_back(NumaNode{ 0, std::vector<size_t>() });
+	}
+}
+bool NumaTopology::PinThread(size_t node) const {
+	if (nodes_.size() < 2 || node >= nodes_.size()) {
+		return false;
+	}
+#if defined(_WIN32)
+	GROUP_AFFINITY affinity = {};
+	if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(nodes_[node].id),
+									&affinity) ||
+		!SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr)) {
+		return false;
+	}
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (auto cpu : nodes_[node].cpus) {
+		CPU_SET(cpu, &set);
+	}
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+		return false;
+	}
+#else
+	return false;
+#endif
+	current_node = node;
+	return true;
+}
+void NumaTopology::RunOnNode(size_t node,
+							 const std::function<void()> &fn) const {
+	/* Run anyway if pinning fails; the memory just lands wherever */
+	std::thread worker([this, node, &fn] {
+		PinThread(node);
+		fn();
+	});
+	worker.join();
+}
+
+/* Private Accessors */
+size_t NumaTopology::GetNodeCount() const {
+	return nodes_.size();
+}
+size_t NumaTopology::GetCurrentNode() {
+	return current_node;
+}
+
+/* Private Helper Functions */
+void NumaTopology::Detect() {
+#if defined(_WIN32)
+	ULONG highest = 0;
+	if (!GetNumaHighestNodeNumber(&highest)) {
+		return;
+	}
+	for (ULONG id = 0; id <= highest; ++id) {
+		GROUP_AFFINITY affinity = {};
+		if (GetNumaNodeProcessorMaskEx(static_cast<USHORT>(id), &affinity) &&
+			affinity.Mask != 0) {
+			nodes_.push_back(NumaNode{ id, std::vector<size_t>() });
+		}
+	}
+#elif defined(__linux__)
+	/*
+	 * Only processors the process may already use count, so a cpuset or
+	 * taskset that confines it to one socket leaves a single node.
+	 */
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+		return;
+	}
+	const std::string kNodePath = "/sys/devices/system/node/";
+	std::ifstream online(kNodePath + "online");
+	std::string list;
+	if (!std::getline(online, list)) {
+		return;
+	}
+	for (auto id : ParseList(list)) {
+		std::ifstream cpulist(kNodePath + "node" + std::to_string(id) +
+							  "/cpulist");
+		std::string cpus;
+		std::getline(cpulist, cpus);
+		NumaNode numa_node{ id, std::vector<size_t>() };
+		for (auto cpu : ParseList(cpus)) {
+			if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+				numa_node.cpus.push_back(cpu);
+			}
+		}
+		if (!numa_node.cpus.empty()) {
+			nodes_.push_back(numa_node);
+		}
+	}
+#endif
+}
+
+/* Helper Functions */
+#if defined(__linux__)
+static std::vector<size_t> ParseList(const std::string &list) {
+	/* Expands the kernel's list format, such as "0-3,8-11", to numbers */
+	std::vector<size_t> numbers;
+	std::istringstream in(list);
+	std::string range;
+	while (std::getline(in, range, ',')) {
+		char *stop = nullptr;
+		size_t first = std::strtoull(range.c_str(), &stop, 10);
+		size_t last = first;
+		if (stop != range.c_str() && *stop == '-') {
+			last = std::strtoull(stop + 1, &stop, 10);
+		}
+		if (stop == range.c_str() || *stop != '\0') {
+			return std::vector<size_t>();
+		}
+		for (size_t n = first; n <= last; ++n) {
+			numbers.push_back(n);
+		}
+	}
+	return numbers;
+}
+#endif
@@ -0,0 +1,68 @@
+/*
+* numa_topology.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for NumaTopology class - finds the machine's NUMA nodes and
+* pins threads to them
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*
+ * The NUMA nodes this process may run on, as found at construction:
+ * /sys/devices/system/node on Linux, the NUMA API on Windows.  Anywhere
+ * else, or when nothing can be read, the machine is one node and
+ * pinning does nothing, so callers need no special case for it.
+ *
+ * Memory is placed on the node of the thread that first touches it, so
+ * data a pinned thread builds for itself is local to that thread.
+ */
+class NumaTopology {
+public:
+	/* GetCurrentNode for a thread that was never pinned */
+	static const size_t kNoNode = SIZE_MAX;
+
+	NumaTopology();
+
+	/*
+	 * Restricts the calling thread to node's processors.  Returns false,
+	 * leaving the thread as it was, if that is not possible.
+	 */
+	bool PinThread(size_t node) const;
+
+	/* Calls fn on a new thread pinned to node and waits for it */
+	void RunOnNode(size_t node, const std::function<void()> &fn) const;
+
+	/* Private Accessors */
+	size_t GetNodeCount() const;
+	static size_t GetCurrentNode();
+private:
+	struct NumaNode {
+		size_t id; /* The system's number for it */
+		std::vector<size_t> cpus; /* Allowed processors; Linux only */
+	};
+
+	void Detect();
+
+	std::vector<NumaNode> nodes_;
+};
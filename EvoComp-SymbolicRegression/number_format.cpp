@@ -0,0 +1,78 @@
+/*
+* number_format.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Helpers for appending numbers to an output buffer without temporaries
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "number_format.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__has_include)
+#if __has_include(<charconv>) && __cplusplus >= 201703L
+#include <charconv>
+#endif
+#endif
+
+void AppendDouble(std::string &out, double value) {
+	char buf[32];
+
+	/* Integral values are common for constants and sizes; skip snprintf */
+	if (value == std::floor(value) && std::fabs(value) < 1e15) {
+		if (std::signbit(value)) { /* Keeps -0 distinct from 0 */
+			out.push_back('-');
+			value = -value;
+		}
+		AppendSize(out, static_cast<size_t>(value));
+		return;
+	}
+	if (!std::isfinite(value)) {
+		if (std::isnan(value)) {
+			out.append("nan");
+		} else {
+			out.append(value < 0 ? "-inf" : "inf");
+		}
+		return;
+	}
+#if defined(__cpp_lib_to_chars)
+	/* Shortest round trip in one pass where the library has it */
+	char *end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+	out.append(buf, static_cast<size_t>(end - buf));
+#else
+	int len = std::snprintf(buf, sizeof(buf), "%.15g", value);
+	if (std::strtod(buf, nullptr) != value) {
+		len = std::snprintf(buf, sizeof(buf), "%.16g", value);
+		if (std::strtod(buf, nullptr) != value) {
+			len = std::snprintf(buf, sizeof(buf), "%.17g", value);
+		}
+	}
+	out.append(buf, static_cast<size_t>(len));
+#endif
+}
+void AppendSize(std::string &out, size_t value) {
+	char buf[24];
+	char *end = buf + sizeof(buf);
+	char *cur = end;
+
+	do {
+		*--cur = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value);
+	out.append(cur, static_cast<size_t>(end - cur));
+}
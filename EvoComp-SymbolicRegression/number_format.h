@@ -0,0 +1,33 @@
+/*
+* number_format.h
+* UIdaho CS-572: Evolutionary Computation
+* Helpers for appending numbers to an output buffer without temporaries
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+ * Shortest text that parses back to exactly value, sign of zero included;
+ * std::to_chars where available, else the shortest of %.15g/%.16g/%.17g
+ */
+void AppendDouble(std::string &out, double value);
+void AppendSize(std::string &out, size_t value);
@@ -0,0 +1,146 @@
+/*
+* operator_kernels.h
+* UIdaho CS-572: Evolutionary Computation
+* Scalar and batch kernels for every function in operator_types.h.
+* Each OpType gets its own specialization so dispatch tables built from
+* these templates can be fully inlined by the compiler.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include "operator_types.h"
+
+/*
+ * Kernel<op>::Apply is the value of the function and Kernel<op>::Partials
+ * its derivative with respect to each argument.  Unary functions ignore
+ * right.  The protection rules live here, so the scalar, batch and tape
+ * evaluators can never disagree on them.
+ */
+template <int Op> struct Kernel;
+
+template <> struct Kernel<kAdd> {
+	template <typename T> static T Apply(T left, T right) {
+		return left + right;
+	}
+	static void Partials(double, double, double &dl, double &dr) {
+		dl = 1;
+		dr = 1;
+	}
+};
+template <> struct Kernel<kSub> {
+	template <typename T> static T Apply(T left, T right) {
+		return left - right;
+	}
+	static void Partials(double, double, double &dl, double &dr) {
+		dl = 1;
+		dr = -1;
+	}
+};
+template <> struct Kernel<kMult> {
+	template <typename T> static T Apply(T left, T right) {
+		return left * right;
+	}
+	static void Partials(double left, double right, double &dl, double &dr) {
+		dl = right;
+		dr = left;
+	}
+};
+template <> struct Kernel<kDiv> {
+	/* Safe Division: dividing by zero divides by one instead */
+	template <typename T> static T Apply(T left, T right) {
+		return left / ((right == 0) ? T(1) : right);
+	}
+	static void Partials(double left, double right, double &dl, double &dr) {
+		dl = (right == 0) ? 1 : 1 / right;
+		dr = (right == 0) ? 0 : -left / (right * right);
+	}
+};
+template <> struct Kernel<kSin> {
+	template <typename T> static T Apply(T left, T) {
+		return std::sin(left);
+	}
+	static void Partials(double left, double, double &dl, double &dr) {
+		dl = std::cos(left);
+		dr = 0;
+	}
+};
+template <> struct Kernel<kCos> {
+	template <typename T> static T Apply(T left, T) {
+		return std::cos(left);
+	}
+	static void Partials(double left, double, double &dl, double &dr) {
+		dl = -std::sin(left);
+		dr = 0;
+	}
+};
+template <> struct Kernel<kExp> {
+	template <typename T> static T Apply(T left, T) {
+		return std::exp(left);
+	}
+	static void Partials(double left, double, double &dl, double &dr) {
+		dl = std::exp(left);
+		dr = 0;
+	}
+};
+template <> struct Kernel<kLog> {
+	/* Protected log: log|x|, and 0 where x == 0 */
+	template <typename T> static T Apply(T left, T) {
+		return (left == 0) ? T(0) : std::log(std::fabs(left));
+	}
+	static void Partials(double left, double, double &dl, double &dr) {
+		dl = (left == 0) ? 0 : 1 / left;
+		dr = 0;
+	}
+};
+template <> struct Kernel<kSqrt> {
+	/* Protected square root: sqrt|x| */
+	template <typename T> static T Apply(T left, T) {
+		return std::sqrt(std::fabs(left));
+	}
+	static void Partials(double left, double, double &dl, double &dr) {
+		double root = std::sqrt(std::fabs(left));
+		dl = (left == 0) ? 0 : ((left < 0) ? -0.5 : 0.5) / root;
+		dr = 0;
+	}
+};
+template <> struct Kernel<kSquare> {
+	template <typename T> static T Apply(T left, T) {
+		return left * left;
+	}
+	static void Partials(double left, double, double &dl, double &dr) {
+		dl = 2 * left;
+		dr = 0;
+	}
+};
+
+/* Runs one kernel over count elements; right is unused for unary ops */
+template <int Op, typename T>
+void ApplyBatch(const T *left, const T *right, T *out, size_t count) {
+	if (right) {
+		for (size_t i = 0; i < count; ++i) {
+			out[i] = Kernel<Op>::Apply(left[i], right[i]);
+		}
+	} else {
+		for (size_t i = 0; i < count; ++i) {
+			out[i] = Kernel<Op>::Apply(left[i], T(0));
+		}
+	}
+}
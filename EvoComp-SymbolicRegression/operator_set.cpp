@@ -0,0 +1,129 @@
+/*
+* operator_set.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Implementation of OperatorSet class - the functions a run may build
+* trees from
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "operator_set.h"
+#include <cstdlib>
+#include <iostream>
+#include "operator_table.h"
+
+static bool ParseNames(const std::string &names, std::vector<OpType> &ops,
+					   std::string &error);
+
+OperatorSet::OperatorSet() {
+	Add(kAdd);
+	Add(kSub);
+	Add(kMult);
+	Add(kDiv);
+}
+OperatorSet::OperatorSet(const std::string &names) {
+	/* names is a whitespace separated list of tokens, e.g. "+ - * / sin" */
+	std::vector<OpType> ops;
+	std::string error;
+	if (!ParseNames(names, ops, error)) {
+		std::cerr << error << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	for (auto op : ops) {
+		Add(op);
+	}
+}
+bool OperatorSet::IsValid(const std::string &names, std::string &error) {
+	/* Whether the constructor would accept names, without exiting */
+	std::vector<OpType> ops;
+	return ParseNames(names, ops, error);
+}
+std::string OperatorSet::ToString() {
+	std::string out;
+	for (auto op : functions_) {
+		if (!out.empty()) {
+			out.push_back(' ');
+		}
+		out.append(GetOperatorInfo(op).name);
+	}
+	return out;
+}
+bool OperatorSet::Contains(OpType op) const {
+	for (auto f : functions_) {
+		if (f == op) {
+			return true;
+		}
+	}
+	return false;
+}
+OpType OperatorSet::GetRandomFunction(std::mt19937 &mt) const {
+	std::uniform_int_distribution<size_t> d{ 0,functions_.size() - 1 };
+	return functions_[d(mt)];
+}
+OpType OperatorSet::GetRandomFunction(size_t arity, std::mt19937 &mt) const {
+	/* Returns kConst when the set has no function of that arity */
+	if (arity >= 3 || by_arity_[arity].empty()) {
+		return kConst;
+	}
+	const std::vector<OpType> &group = by_arity_[arity];
+	std::uniform_int_distribution<size_t> d{ 0,group.size() - 1 };
+	return group[d(mt)];
+}
+
+/* Private Accessors/Mutators */
+size_t OperatorSet::GetFunctionCount() const {
+	return functions_.size();
+}
+OpType OperatorSet::GetFunction(size_t index) const {
+	return functions_[index];
+}
+void OperatorSet::Add(OpType op) {
+	if (Contains(op)) {
+		return;
+	}
+	functions_.push_back(op);
+	by_arity_[GetArity(op)].push_back(op);
+}
+
+/* Helper Functions */
+static bool ParseNames(const std::string &names, std::vector<OpType> &ops,
+					   std::string &error) {
+	size_t pos = 0;
+	while (pos < names.size()) {
+		size_t start = names.find_first_not_of(" \t,", pos);
+		if (start == std::string::npos) {
+			break;
+		}
+		size_t end = names.find_first_of(" \t,", start);
+		if (end == std::string::npos) {
+			end = names.size();
+		}
+		OpType op = FindOperator(names.c_str() + start, end - start);
+		if (op == kConst) {
+			error = "Unknown operator \"" + names.substr(start, end - start) +
+				"\"";
+			return false;
+		}
+		ops.push_back(op);
+		pos = end;
+	}
+	if (ops.empty()) {
+		error = "Operator set is empty!";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,50 @@
+/*
+* operator_set.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for OperatorSet class - the functions a run may build trees from
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+#include "operator_types.h"
+
+class OperatorSet {
+public:
+	OperatorSet(); /* + - * / */
+	explicit OperatorSet(const std::string &names);
+
+	static bool IsValid(const std::string &names, std::string &error);
+
+	std::string ToString();
+	bool Contains(OpType op) const;
+	OpType GetRandomFunction(std::mt19937 &mt) const;
+	OpType GetRandomFunction(size_t arity, std::mt19937 &mt) const;
+
+	/* Private Accessors/Mutators */
+	size_t GetFunctionCount() const;
+	OpType GetFunction(size_t index) const;
+private:
+	void Add(OpType op);
+
+	std::vector<OpType> functions_;
+	std::vector<OpType> by_arity_[3]; /* Same functions, grouped by arity */
+};
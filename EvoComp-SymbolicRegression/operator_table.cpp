@@ -0,0 +1,61 @@
+/*
+* operator_table.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Registry of every operator: arity, printers and the dispatch tables
+* that route an OpType to its kernel in operator_kernels.h.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "operator_table.h"
+#include <cstring>
+#include <iostream>
+
+/* Indexed by OpType */
+static const OperatorInfo kOperators[kOpTypeCount] = {
+	{ static_cast<OpType>(0), 0, "", { "", "", "" }, { "", "", "" } },
+	{ kAdd, 2, "+", { "", " + ", "" }, { "", " + ", "" } },
+	{ kSub, 2, "-", { "", " - ", "" }, { "", " - ", "" } },
+	{ kMult, 2, "*", { "(", ")(", ")" }, { "(", ")(", ")" } },
+	{ kDiv, 2, "/", { "(", " / ", ")" }, { "\\frac{", "}{", "}" } },
+	{ kSin, 1, "sin", { "sin(", "", ")" }, { "\\sin(", "", ")" } },
+	{ kCos, 1, "cos", { "cos(", "", ")" }, { "\\cos(", "", ")" } },
+	{ kExp, 1, "exp", { "exp(", "", ")" }, { "e^{", "", "}" } },
+	{ kLog, 1, "log", { "log|", "", "|" }, { "\\log|", "", "|" } },
+	{ kSqrt, 1, "sqrt", { "sqrt|", "", "|" }, { "\\sqrt{|", "", "|}" } },
+	{ kSquare, 1, "sq", { "(", "", ")^2" }, { "(", "", ")^{2}" } },
+	{ kConst, 0, "const", { "", "", "" }, { "", "", "" } },
+	{ kVar, 0, "var", { "", "", "" }, { "", "", "" } }
+};
+
+const OperatorInfo& GetOperatorInfo(OpType op) {
+	if (op <= 0 || op >= kOpTypeCount) {
+		std::cerr << "Node has no OpType!" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	return kOperators[op];
+}
+OpType FindOperator(const char *name, size_t length) {
+	/* Returns the function called name, or kConst if there is none */
+	for (int op = kAdd; op < kConst; ++op) {
+		if (std::strlen(kOperators[op].name) == length &&
+			std::strncmp(kOperators[op].name, name, length) == 0) {
+			return static_cast<OpType>(op);
+		}
+	}
+	return kConst;
+}
@@ -0,0 +1,107 @@
+/*
+* operator_table.h
+* UIdaho CS-572: Evolutionary Computation
+* Registry of every operator: arity, printers and the dispatch tables
+* that route an OpType to its kernel in operator_kernels.h.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include "operator_kernels.h"
+#include "operator_types.h"
+
+/*
+ * Everything the tree code needs to know about an operator.  Printers
+ * are {before, between, after}; between is only used for binary ops.
+ * The protection rules themselves live in the kernels.
+ */
+struct OperatorInfo {
+	OpType op;
+	size_t arity; /* 0 for terminals */
+	const char *name; /* Token used by operator sets and prefix output */
+	const char *infix[3];
+	const char *latex[3];
+};
+
+const OperatorInfo& GetOperatorInfo(OpType op);
+OpType FindOperator(const char *name, size_t length);
+
+inline size_t GetArity(OpType op) {
+	return GetOperatorInfo(op).arity;
+}
+
+/* Scalar dispatch; each case inlines its kernel */
+inline double ApplyOperator(OpType op, double left, double right) {
+	switch (op) {
+	case kAdd: return Kernel<kAdd>::Apply(left, right);
+	case kSub: return Kernel<kSub>::Apply(left, right);
+	case kMult: return Kernel<kMult>::Apply(left, right);
+	case kDiv: return Kernel<kDiv>::Apply(left, right);
+	case kSin: return Kernel<kSin>::Apply(left, right);
+	case kCos: return Kernel<kCos>::Apply(left, right);
+	case kExp: return Kernel<kExp>::Apply(left, right);
+	case kLog: return Kernel<kLog>::Apply(left, right);
+	case kSqrt: return Kernel<kSqrt>::Apply(left, right);
+	case kSquare: return Kernel<kSquare>::Apply(left, right);
+	default: return 0;
+	}
+}
+inline void OperatorPartials(OpType op, double left, double right,
+							 double &dl, double &dr) {
+	switch (op) {
+	case kAdd: Kernel<kAdd>::Partials(left, right, dl, dr); break;
+	case kSub: Kernel<kSub>::Partials(left, right, dl, dr); break;
+	case kMult: Kernel<kMult>::Partials(left, right, dl, dr); break;
+	case kDiv: Kernel<kDiv>::Partials(left, right, dl, dr); break;
+	case kSin: Kernel<kSin>::Partials(left, right, dl, dr); break;
+	case kCos: Kernel<kCos>::Partials(left, right, dl, dr); break;
+	case kExp: Kernel<kExp>::Partials(left, right, dl, dr); break;
+	case kLog: Kernel<kLog>::Partials(left, right, dl, dr); break;
+	case kSqrt: Kernel<kSqrt>::Partials(left, right, dl, dr); break;
+	case kSquare: Kernel<kSquare>::Partials(left, right, dl, dr); break;
+	default: dl = dr = 0; break;
+	}
+}
+
+/*
+ * Batch dispatch: one indirect call per node per block of rows, after
+ * which the loop body is the specialized kernel.  Terminals have no entry.
+ */
+template <typename T>
+inline void ApplyOperatorBatch(OpType op, const T *left, const T *right,
+							   T *out, size_t count) {
+	typedef void (*BatchKernel)(const T*, const T*, T*, size_t);
+	static const BatchKernel kTable[kOpTypeCount] = {
+		nullptr,
+		ApplyBatch<kAdd, T>,
+		ApplyBatch<kSub, T>,
+		ApplyBatch<kMult, T>,
+		ApplyBatch<kDiv, T>,
+		ApplyBatch<kSin, T>,
+		ApplyBatch<kCos, T>,
+		ApplyBatch<kExp, T>,
+		ApplyBatch<kLog, T>,
+		ApplyBatch<kSqrt, T>,
+		ApplyBatch<kSquare, T>,
+		nullptr, /* kConst */
+		nullptr /* kVar */
+	};
+	kTable[op](left, right, out, count);
+}
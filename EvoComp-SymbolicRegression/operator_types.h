@@ -21,11 +21,20 @@
 * along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
-enum OpType {
+
+#include <cstdint>
+enum OpType : uint8_t { /* One byte, so it packs into Node */
 	kAdd = 1,
 	kSub = 2,
 	kMult = 3,
 	kDiv = 4,
-	kConst = 5,
-	kVar = 6
-};
\ No newline at end of file
+	kSin = 5,
+	kCos = 6,
+	kExp = 7,
+	kLog = 8,
+	kSqrt = 9,
+	kSquare = 10,
+	kConst = 11,
+	kVar = 12
+};
+const int kOpTypeCount = 13; /* One past the largest OpType */
\ No newline at end of file
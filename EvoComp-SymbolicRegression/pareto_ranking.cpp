@@ -0,0 +1,147 @@
+/*
+* pareto_ranking.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Implementation of ParetoRanking class
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "pareto_ranking.h"
+#include <algorithm>
+#include <limits>
+
+ParetoRanking::ParetoRanking() {
+	front_count_ = 0;
+}
+void ParetoRanking::Rank(const std::vector<double> &first,
+						 const std::vector<double> &second) {
+	/*
+	 * Two-objective sort after Jensen: visit the points by increasing
+	 * first objective (ties by the second), so a point can only be
+	 * dominated by one visited earlier, and the most recent member of
+	 * each front is the one most likely to dominate it.  Those members
+	 * are ordered across fronts, so a binary search finds the first
+	 * front whose most recent member does not dominate the point.
+	 */
+	size_t n = first.size();
+	const double kWorst = std::numeric_limits<double>::infinity();
+	first_.resize(n);
+	second_.resize(n);
+	order_.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		first_[i] = (first[i] == first[i]) ? first[i] : kWorst;
+		second_[i] = (second[i] == second[i]) ? second[i] : kWorst;
+		order_[i] = i;
+	}
+	std::sort(order_.begin(), order_.end(), [this](size_t a, size_t b) {
+		if (first_[a] != first_[b]) {
+			return first_[a] < first_[b];
+		}
+		return second_[a] < second_[b];
+	});
+
+	rank_.resize(n);
+	for (size_t f = 0; f < front_count_; ++f) {
+		fronts_[f].clear();
+	}
+	front_count_ = 0;
+	for (auto i : order_) {
+		size_t low = 0;
+		size_t high = front_count_;
+		while (low < high) {
+			size_t mid = low + (high - low) / 2;
+			if (Dominates(fronts_[mid].back(), i)) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		if (low == front_count_) {
+			if (fronts_.size() == front_count_) {
+				fronts_.push_back(std::vector<size_t>());
+			}
+			++front_count_;
+		}
+		fronts_[low].push_back(i);
+		rank_[i] = low;
+	}
+
+	crowding_.resize(n);
+	for (size_t f = 0; f < front_count_; ++f) {
+		CalculateCrowding(fronts_[f]);
+	}
+}
+void ParetoRanking::CrowdedOrder(std::vector<size_t> &order) {
+	order = order_;
+	std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+		if (rank_[a] != rank_[b]) {
+			return rank_[a] < rank_[b];
+		}
+		return crowding_[a] > crowding_[b];
+	});
+}
+size_t ParetoRanking::GetFrontCount() {
+	return front_count_;
+}
+const std::vector<size_t>& ParetoRanking::GetFront(size_t front) {
+	return fronts_[front];
+}
+size_t ParetoRanking::GetRank(size_t i) {
+	return rank_[i];
+}
+double ParetoRanking::GetCrowding(size_t i) {
+	return crowding_[i];
+}
+
+/* Private Helper Functions */
+bool ParetoRanking::Dominates(size_t a, size_t b) {
+	return first_[a] <= first_[b] && second_[a] <= second_[b] &&
+		(first_[a] < first_[b] || second_[a] < second_[b]);
+}
+void ParetoRanking::CalculateCrowding(const std::vector<size_t> &front) {
+	/*
+	 * A front is already ordered by increasing first objective, and so
+	 * by decreasing second, so no per-objective sort is needed.  The two
+	 * ends are always kept; an infinite objective (a NaN or overflowing
+	 * fitness) is clamped so the normalized gaps stay finite.
+	 */
+	const double kInfinity = std::numeric_limits<double>::infinity();
+	const double kLargest = std::numeric_limits<double>::max();
+	size_t count = front.size();
+	crowding_[front[0]] = kInfinity;
+	crowding_[front[count - 1]] = kInfinity;
+	if (count < 3) {
+		return;
+	}
+	auto clamp = [kLargest](double v) { return std::min(v, kLargest); };
+	double first_range = clamp(first_[front[count - 1]]) -
+		clamp(first_[front[0]]);
+	double second_range = clamp(second_[front[0]]) -
+		clamp(second_[front[count - 1]]);
+	for (size_t k = 1; k + 1 < count; ++k) {
+		double distance = 0;
+		if (first_range > 0) {
+			distance += (clamp(first_[front[k + 1]]) -
+						 clamp(first_[front[k - 1]])) / first_range;
+		}
+		if (second_range > 0) {
+			distance += (clamp(second_[front[k - 1]]) -
+						 clamp(second_[front[k + 1]])) / second_range;
+		}
+		crowding_[front[k]] = distance;
+	}
+}
@@ -0,0 +1,64 @@
+/*
+* pareto_ranking.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for ParetoRanking class - non-dominated sorting and crowding
+* distance over two minimized objectives, as used by NSGA-II
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class ParetoRanking {
+public:
+	ParetoRanking();
+
+	/*
+	 * Sorts the points (first[i], second[i]) into non-dominated fronts,
+	 * front 0 being dominated by nothing, and gives every point its
+	 * crowding distance within its front.  Both objectives are minimized
+	 * and NaN counts as the worst value.  Runs in O(n log n).
+	 */
+	void Rank(const std::vector<double> &first,
+			  const std::vector<double> &second);
+
+	/*
+	 * Fills order with every point in crowded-comparison order: lower
+	 * front first, then larger crowding distance first.
+	 */
+	void CrowdedOrder(std::vector<size_t> &order);
+	
+	size_t GetFrontCount();
+	/* Members of a front, by increasing first objective */
+	const std::vector<size_t>& GetFront(size_t front);
+	size_t GetRank(size_t i);
+	double GetCrowding(size_t i);
+private:
+	bool Dominates(size_t a, size_t b);
+	void CalculateCrowding(const std::vector<size_t> &front);
+
+	std::vector<double> first_;
+	std::vector<double> second_;
+	std::vector<size_t> order_;
+	std::vector<size_t> rank_;
+	std::vector<double> crowding_;
+	std::vector<std::vector<size_t>> fronts_;
+	size_t front_count_; /* fronts_ is only ever grown */
+};
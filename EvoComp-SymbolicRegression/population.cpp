@@ -21,24 +21,91 @@
 * along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "population.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <iostream> /* For debugging/logging only */
+#include <limits>
 #include <random>
-#include <sstream>
+#include "number_format.h"
 
 Population::Population(size_t population_size, double mutation_rate,
 					   double nonterminal_crossover_rate, 
 					   size_t tournament_size, size_t depth_min, 
 					   size_t depth_max, double const_min, double const_max, 
-					   size_t var_count, std::vector<SolutionData> solutions) {
-	solutions_ = solutions;
+					   size_t var_count,
+					   const std::vector<SolutionData> &solutions,
+					   const OperatorSet &operators, uint32_t seed)
+	: Population(population_size, mutation_rate, nonterminal_crossover_rate,
+				 tournament_size, depth_min, depth_max, const_min, const_max,
+				 var_count, Dataset(solutions), operators, seed) {}
+Population::Population(size_t population_size, double mutation_rate,
+					   double nonterminal_crossover_rate,
+					   size_t tournament_size, size_t depth_min,
+					   size_t depth_max, double const_min, double const_max,
+					   size_t var_count, Dataset data,
+					   const OperatorSet &operators, uint32_t seed)
+	: data_(std::move(data)), operators_(operators),
+	  context_(var_count, const_min, const_max), intervals_(data_) {
+	block_evaluator_ = SelectBlockEvaluator(data_.GetColumnCount(),
+											operators_);
+	static_analysis_ = false;
+	numa_aware_ = false;
 
 	mutation_rate_ = mutation_rate;
 	nonterminal_crossover_rate_ = nonterminal_crossover_rate;
 	tournament_size_ = tournament_size;
+	SetSelectionType(kTournamentSelection);
+	pool_.reset(new ThreadPool);
+	constant_opt_count_ = 0;
+	constant_opt_iterations_ = 0;
+	simplify_mode_ = kSimplifyOff;
+	init_type_ = kRampedHalfAndHalf;
+	steady_state_ = false;
+	replacements_ = 0;
+	async_in_flight_ = 0;
+	async_size_priority_ = true;
+	init_size_min_ = 1;
+	init_size_max_ = 1;
+	unique_init_ = false;
+	precision_ = kDoublePrecision;
+	rescore_count_ = 0;
+	row_tile_rows_ = 0;
+	simplified_nodes_ = 0;
+	static_scores_ = 0;
+	tree_size_limit_ = 0;
+	tree_depth_limit_ = 0;
+	rejected_crossovers_ = 0;
+	parsimony_coefficient_ = 0;
+	share_duplicate_fitness_ = false;
+	duplicate_policy_ = kDuplicatesAllowed;
+	duplicate_penalty_ = 0;
+	skipped_evaluations_ = 0;
+	reused_evaluations_ = 0;
+	rejected_duplicates_ = 0;
+	semantic_diversity_ = 0;
+	structural_diversity_ = 0;
+
+	/* Probe rows for fingerprints, spread evenly through the data */
+	const size_t kProbeRows = 32;
+	size_t rows = data_.GetRowCount();
+	size_t probe_count = std::min(kProbeRows, rows);
+	probe_.Resize(probe_count, data_.GetColumnCount());
+	for (size_t col = 0; col < data_.GetColumnCount(); ++col) {
+		const double *from = data_.GetColumn<double>(col);
+		double *to = probe_.GetMutableColumn(col);
+		for (size_t i = 0; i < probe_count; ++i) {
+			to[i] = from[i * rows / probe_count];
+		}
+	}
 
-	var_count_ = var_count;
-	const_min_ = const_min;
-	const_max_ = const_max;
+	replay_ = (seed != 0);
+	if (!replay_) {
+		std::random_device rd;
+		seed = rd();
+	}
+	seed_ = seed;
+	rng_.seed(seed_);
 
 	best_fitness_ = DBL_MAX;
 	worst_fitness_ = DBL_MIN;
@@ -47,6 +114,8 @@ Population::Population(size_t population_size, double mutation_rate,
 	largest_tree_ = 0;
 	smallest_tree_ = SIZE_MAX;
 	avg_tree_ = 0;
+	deepest_tree_ = 0;
+	avg_depth_ = 0;
 
 	/* Generate the population */
 	if (depth_min > depth_max) {
@@ -57,46 +126,156 @@ Population::Population(size_t population_size, double mutation_rate,
 	if (population_size % 2 != 0) {
 		++population_size; /* Force population to be even */
 	}
-	RampedHalfAndHalf(population_size, depth_min, depth_max);
-	CalculateFitness();
+	depth_min_ = depth_min;
+	depth_max_ = depth_max;
+	initial_size_ = population_size;
+	initialized_ = false;
+}
+
+Population::~Population() {
+	/* Every tree in pop_ has exactly one owner, so each is freed once */
+	for (auto &p : pop_) {
+		p.Erase();
+	}
 }
 
 /* Genetic Program Functions */
-void Population::RampedHalfAndHalf(size_t population_size, 
-	size_t depth_min, size_t depth_max) {
-	unsigned gradations = static_cast<unsigned>(depth_max - depth_min + 1);
-	pop_.reserve(population_size);
-	bool full_tree;
-	for (size_t i = 0; i < population_size; ++i) {	
-		if (i % 2) {
-			full_tree = true;
-		} else {
-			full_tree = false;
+void Population::Initialize() {
+	/*
+	 * Builds and scores the first generation.  It waits for the first
+	 * call that needs it rather than running in the constructor, so the
+	 * Set functions called before then shape the one population built.
+	 */
+	if (initialized_) {
+		return;
+	}
+	initialized_ = true;
+	InitializePopulation(initial_size_);
+	CalculateFitness();
+}
+void Population::InitializePopulation(size_t population_size) {
+	/*
+	 * Every individual is built in parallel straight into its slot of
+	 * pop_, each from its own generator seeded by (run seed, index) so
+	 * the result does not depend on the thread count.  With unique
+	 * initialization, individuals whose fingerprint repeats an earlier
+	 * one are rebuilt, for a few rounds at most.
+	 */
+	const size_t kUniqueRounds = 8;
+	uint32_t seed = static_cast<uint32_t>(rng_());
+	pop_.resize(population_size);
+	pool_->ParallelFor(population_size, [this, seed](size_t i) {
+		std::seed_seq seq{ seed, static_cast<uint32_t>(i), 0u };
+		std::mt19937 mt(seq);
+		InitializeIndividual(i, mt);
+	});
+	if (!unique_init_) {
+		return;
+	}
+
+	std::vector<size_t> repeats;
+	for (size_t round = 1; round <= kUniqueRounds; ++round) {
+		fingerprint_index_.clear();
+		repeats.clear();
+		for (size_t i = 0; i < pop_.size(); ++i) {
+			if (!fingerprint_index_.insert(
+				std::make_pair(pop_[i].GetFingerprint(), i)).second) {
+				repeats.push_back(i);
+			}
+		}
+		if (repeats.empty()) {
+			break;
 		}
-		pop_.push_back(Individual(var_count_, const_min_, const_max_,
-			(depth_min + i % gradations), full_tree));
+		pool_->ParallelFor(repeats.size(), [&](size_t k) {
+			size_t i = repeats[k];
+			std::seed_seq seq{ seed, static_cast<uint32_t>(i),
+							   static_cast<uint32_t>(round) };
+			std::mt19937 mt(seq);
+			pop_[i].Erase();
+			InitializeIndividual(i, mt);
+		});
+	}
+}
+void Population::InitializeIndividual(size_t i, std::mt19937 &mt) {
+	/*
+	 * Ramped half-and-half alternates grow and full and ramps the depth
+	 * with the index; PTC2 draws its target size uniformly from
+	 * [init_size_min_, init_size_max_].
+	 */
+	switch (init_type_) {
+	case kPTC2: {
+		std::uniform_int_distribution<size_t> d{ init_size_min_,
+												 init_size_max_ };
+		pop_[i].GenerateTreePTC2(d(mt), depth_max_, context_, operators_,
+								 mt);
+		break;
+	}
+	default: {
+		size_t gradations = depth_max_ - depth_min_ + 1;
+		bool full_tree = (i % 2 != 0);
+		pop_[i].GenerateTree(depth_min_ + i % gradations, full_tree,
+							 context_, operators_, mt);
+		break;
+	}
+	}
+	if (unique_init_) {
+		pop_[i].CalculateFingerprint(probe_);
 	}
 }
 void Population::MutatePopulation() {
 	for (auto &p : pop_) {
-		p.Mutate(mutation_rate_);
+		p.Mutate(mutation_rate_, context_, operators_, rng_);
 	}
 }
-void Population::Crossover(Individual *parent1, Individual *parent2) {
+bool Population::Crossover(Individual *parent1, Individual *parent2) {
 	/* Get crossover points.  Crossover point of parent1 is the parent
 	 * and identifier of whether left or right child.  Crossover point of 
-	 * parent2 is the node to splice in.
+	 * parent2 is the node to splice in.  Points that would push the child
+	 * past the tree limits are redrawn a few times; if none fit, parent1
+	 * is left untouched and false is returned.  The spliced subtree is
+	 * cut out of parent2, so what is left of parent2 can be erased.
 	 */
-	
-	std::random_device rd;
-	std::mt19937 mt(rd());
+	const size_t kCrossoverAttempts = 8;
 	std::uniform_real_distribution<double> d{ 0,1 };
 
-	bool p1_nonterminal = (d(mt) < nonterminal_crossover_rate_);
-	bool p2_nonterminal = (d(mt) < nonterminal_crossover_rate_);
-	
-	std::pair<Node*, bool> c1 = parent1->GetRandomNode(p1_nonterminal);
-	std::pair<Node*, bool> c2 = parent2->GetRandomNode(p2_nonterminal);
+	std::pair<Node*, bool> c1;
+	std::pair<Node*, bool> c2;
+	bool fits = false;
+	for (size_t attempt = 0; attempt < kCrossoverAttempts && !fits; ++attempt) {
+		bool p1_nonterminal = (d(rng_) < nonterminal_crossover_rate_);
+		bool p2_nonterminal = (d(rng_) < nonterminal_crossover_rate_);
+
+		c1 = parent1->GetRandomNode(p1_nonterminal, rng_);
+		c2 = parent2->GetRandomNode(p2_nonterminal, rng_);
+		fits = true;
+
+		/*
+		 * parent1 is already within the limits, so the child is as long
+		 * as the spliced subtree fits where it lands.
+		 */
+		if (tree_size_limit_) {
+			size_t child_size = parent1->GetTreeSize() -
+				c1.first->GetSubtreeSize() + c2.first->GetSubtreeSize();
+			fits = (child_size <= tree_size_limit_);
+		}
+		if (fits && tree_depth_limit_) {
+			size_t child_depth = c1.first->GetDepth() + c2.first->GetHeight();
+			fits = (child_depth <= tree_depth_limit_);
+		}
+	}
+	if (!fits) {
+		++rejected_crossovers_;
+		return false;
+	}
+
+	Node *donor = c2.first->GetParent();
+	if (!donor) {
+		parent2->SetRootNode(nullptr);
+	} else if (donor->GetLeftChild() == c2.first) {
+		donor->SetLeftChild(nullptr);
+	} else {
+		donor->SetRightChild(nullptr);
+	}
 
 	/* c1.first could be nullptr in which case new individual is c2 */
 	if (!c1.first->GetParent()) {
@@ -115,105 +294,853 @@ void Population::Crossover(Individual *parent1, Individual *parent2) {
 		}
 	}
 	parent1->CorrectTree();
+	return true;
 }
 void Population::Evolve(size_t elitism_count) {
+	/*
+	 * Mutation only changes a node's operator within its own arity, so it
+	 * can never break the tree limits; only crossover needs to check them.
+	 */
+	Initialize();
 	std::vector<Individual> evolved_pop(pop_.size());
+	rejected_crossovers_ = 0;
+	steady_state_ = false;
+	if (constant_opt_count_) {
+		OptimizeConstants();
+	}
 	std::vector<size_t> elites = Elitism(elitism_count);
 	
-	/* Choosing elite individuals uses raw fitness */
+	/* Choosing elite individuals uses raw fitness; elites get a copy */
 	for (size_t j = 0; j < elitism_count; ++j) {
-		evolved_pop[j] = pop_[elites[j]];
+		Individual elite(pop_[elites[j]]);
+		evolved_pop[j] = elite;
 	}
 
+	/* Gather weighted fitness once, then draw every parent pair at once */
+	selection_fitness_.resize(pop_.size());
+	for (size_t i = 0; i < pop_.size(); ++i) {
+		selection_fitness_[i] = pop_[i].GetWeightedFitness();
+	}
+	selection_->Prepare(selection_fitness_);
+	selection_->SelectParents(pop_.size() - elitism_count, rng_, parents_);
+
+	/*
+	 * Rejecting duplicates re-breeds a child whose fingerprint is already
+	 * in the new generation, up to kDuplicateAttempts times in all.
+	 */
+	const size_t kDuplicateAttempts = 4;
+	rejected_duplicates_ = 0;
+	child_fingerprints_.clear();
+	if (duplicate_policy_ == kDuplicatesRejected) {
+		for (size_t j = 0; j < elitism_count; ++j) {
+			child_fingerprints_.insert(evolved_pop[j].GetFingerprint());
+		}
+	}
 	for (size_t j = elitism_count; j < pop_.size(); ++j) {
-		size_t p1 = SelectIndividual();
-		size_t p2;
-		do {
-			p2 = SelectIndividual();
-		} while (p2 == p1);
-
-		Individual parent1(pop_[p1]);
-		Individual parent2(pop_[p2]);
-		Crossover(&parent1, &parent2);
+		size_t p1 = parents_[j - elitism_count].first;
+		size_t p2 = parents_[j - elitism_count].second;
+
+		for (size_t attempt = 1; ; ++attempt) {
+			Individual parent1(pop_[p1]);
+			Individual parent2(pop_[p2]);
+			Crossover(&parent1, &parent2);
+			parent2.Erase();
+			parent1.Mutate(mutation_rate_, context_, operators_, rng_);
 
-		evolved_pop[j] = parent1;
-		evolved_pop[j].Mutate(mutation_rate_);
+			if (duplicate_policy_ != kDuplicatesRejected ||
+				attempt == kDuplicateAttempts ||
+				child_fingerprints_.insert(
+					parent1.CalculateFingerprint(probe_)).second) {
+				evolved_pop[j] = parent1;
+				break;
+			}
+			parent1.Erase();
+			++rejected_duplicates_;
+		}
 	}
-	this->pop_ = evolved_pop;
+	for (auto &p : pop_) {
+		p.Erase();
+	}
+	pop_.swap(evolved_pop);
 	CalculateFitness();
 }
 
-/* Helper Functions */
-size_t Population::SelectIndividual() {
-	size_t winner;
-	size_t challenger;
+void Population::EvolveSteadyState(size_t batch_size) {
+	/*
+	 * One steady-state step: breeds batch_size children, puts each in
+	 * place of a loser picked by inverse tournament, and evaluates them
+	 * across the thread pool.  The best individual by raw and by weighted
+	 * fitness is never a loser.  Stats are updated child by child rather
+	 * than recomputed; after every pop_.size() replacements, constants
+	 * are tuned if enabled and the parsimony coefficient, weighted
+	 * fitness, diversity and stats are refreshed in full.  Selection is
+	 * prepared once per step, so larger batches amortize it better.
+	 */
+	Initialize();
+	if (!steady_state_) {
+		BuildIncrementalStats();
+		steady_state_ = true;
+		replacements_ = 0;
+	}
+	batch_size = std::max<size_t>(1, std::min(batch_size, pop_.size() - 2));
+	if (replacements_ == 0) {
+		rejected_crossovers_ = 0;
+	}
+	simplified_nodes_ = 0;
+	static_scores_ = 0;
 
-	std::random_device rd;
-	std::mt19937 mt(rd());
-	std::uniform_int_distribution<size_t> d{ 0,pop_.size() - 1 };
+	selection_->Prepare(selection_fitness_);
+	selection_->SelectParents(batch_size, rng_, parents_);
+	SelectLosers(batch_size);
+
+	for (size_t k = 0; k < batch_size; ++k) {
+		Individual parent1(pop_[parents_[k].first]);
+		Individual parent2(pop_[parents_[k].second]);
+		Crossover(&parent1, &parent2);
+		parent2.Erase();
+		parent1.Mutate(mutation_rate_, context_, operators_, rng_);
+
+		size_t slot = losers_[k];
+		TrackIndividual(slot, false);
+		pop_[slot].Erase();
+		pop_[slot] = parent1;
+	}
+
+	loser_simplified_.assign(batch_size, 0);
+	pool_->ParallelFor(batch_size, [this](size_t k) {
+		loser_simplified_[k] = EvaluateIndividual(losers_[k], precision_);
+	});
+
+	for (size_t k = 0; k < batch_size; ++k) {
+		simplified_nodes_ += loser_simplified_[k];
+		AcceptChild(losers_[k]);
+	}
+	SyncIncrementalStats();
 
-	winner = d(mt);
+	replacements_ += batch_size;
+	if (replacements_ >= pop_.size()) {
+		RefreshSteadyState();
+	}
+}
+void Population::EvolveAsync(size_t replacement_count) {
+	/*
+	 * Steady state without the per-step barrier: breeding keeps up to
+	 * async_in_flight_ children queued for the evaluation workers, and
+	 * each child takes the place of an inverse-tournament loser as soon
+	 * as its fitness comes back, so one huge tree holds up only itself.
+	 * The queue is topped up once it is half empty, which keeps the
+	 * workers fed while preparing selection only once per refill.
+	 * Returns after replacement_count children have been placed; any
+	 * still in flight are placed by the next call.  Stats, refreshes and
+	 * the protection of the best are the same as EvolveSteadyState.
+	 * When replaying, children are placed in the order they were bred,
+	 * whichever worker finishes first.
+	 */
+	Initialize();
+	if (!steady_state_) {
+		BuildIncrementalStats();
+		steady_state_ = true;
+		replacements_ = 0;
+	}
+	size_t in_flight = async_in_flight_;
+	if (in_flight == 0) {
+		in_flight = 2 * pool_->GetThreadCount();
+	}
+	if (!async_queue_) {
+		async_queue_.reset(new EvaluationQueue(pool_->GetThreadCount(),
+			async_size_priority_, replay_, [this](EvaluationTask &task) {
+			float *errors = nullptr;
+			if (!task.case_errors.empty()) {
+				errors = task.case_errors.data();
+			}
+			/* No cache: EndEpoch may run while the workers do */
+			task.simplified_nodes = EvaluateCandidate(task.individual, errors,
+													  1, precision_, nullptr);
+		}, numa_aware_ ? &numa_ : nullptr));
+	}
+	simplified_nodes_ = 0;
+	static_scores_ = 0;
 
-	for (size_t i = 0; i < tournament_size_; ++i) {
-		challenger = d(mt);
-		if (pop_[challenger].GetWeightedFitness() < 
-			pop_[winner].GetWeightedFitness()) {
-			winner = challenger;
+	const size_t stride = CaseErrorMatrix::kBlockSize;
+	for (size_t placed = 0; placed < replacement_count; ++placed) {
+		if (replacements_ == 0) {
+			rejected_crossovers_ = 0;
+		}
+		size_t pending = async_queue_->GetPendingCount();
+		if (pending <= in_flight / 2) {
+			size_t refill = in_flight - pending;
+			selection_->Prepare(selection_fitness_);
+			selection_->SelectParents(refill, rng_, parents_);
+			for (size_t k = 0; k < refill; ++k) {
+				Individual parent1(pop_[parents_[k].first]);
+				Individual parent2(pop_[parents_[k].second]);
+				Crossover(&parent1, &parent2);
+				parent2.Erase();
+				parent1.Mutate(mutation_rate_, context_, operators_, rng_);
+
+				std::unique_ptr<EvaluationTask> task(new EvaluationTask);
+				task->individual = parent1;
+				task->priority = parent1.GetTreeSize();
+				if (track_case_errors_) {
+					task->case_errors.resize(data_.GetRowCount());
+				}
+				async_queue_->Submit(std::move(task));
+			}
+		}
+
+		std::unique_ptr<EvaluationTask> task = async_queue_->WaitForResult();
+		SelectLosers(1);
+		size_t slot = losers_[0];
+		TrackIndividual(slot, false);
+		pop_[slot].Erase();
+		pop_[slot] = task->individual;
+		if (track_case_errors_ && !task->case_errors.empty()) {
+			float *to = case_errors_.GetIndividual(slot);
+			for (size_t c = 0; c < task->case_errors.size(); ++c) {
+				to[c * stride] = task->case_errors[c];
+			}
+		}
+		simplified_nodes_ += task->simplified_nodes;
+		AcceptChild(slot);
+		SyncIncrementalStats();
+
+		if (++replacements_ >= pop_.size()) {
+			RefreshSteadyState();
 		}
 	}
-	return winner;
 }
-std::vector<size_t> Population::Elitism(size_t elitism_count) {
+void Population::AcceptChild(size_t slot) {
 	/*
-	* This functions returns a vector of the indices of the
-	* "elite_count" most fit individuals in the population.
-	* Currently, the elitism is forced at two individuals until I complete
-	* a sorting algorithm.
-	*/
+	 * Finishes placing an evaluated child in pop_[slot]: re-scores it in
+	 * double if it beats the best in single precision, then weights it
+	 * and adds it to the running stats.
+	 */
+	if (precision_ == kSinglePrecision &&
+		pop_[slot].GetFitness() < best_fitness_) {
+		EvaluateIndividual(slot, kDoublePrecision);
+	}
+	pop_[slot].CalculateWeightedFitness(parsimony_coefficient_);
+	selection_fitness_[slot] = pop_[slot].GetWeightedFitness();
+	TrackIndividual(slot, true);
+	if (pop_[slot].GetFitness() < best_fitness_) {
+		best_fitness_ = pop_[slot].GetFitness();
+		best_index_ = slot;
+	}
+	if (pop_[slot].GetWeightedFitness() < best_weighted_fitness_) {
+		best_weighted_fitness_ = pop_[slot].GetWeightedFitness();
+		best_weighted_index_ = slot;
+	}
+}
+void Population::RefreshSteadyState() {
+	/* The full refresh after every pop_.size() replacements */
+	replacements_ = 0;
+	if (constant_opt_count_) {
+		OptimizeConstants();
+	}
+	CalculateDiversity();
+	CalculateFitnessStats();
+	CalculateTreeSize();
+	CalculateWeightedFitness();
+	BuildIncrementalStats();
+	if (subtree_cache_) {
+		subtree_cache_->EndEpoch();
+	}
+}
+void Population::EvolvePareto() {
+	/*
+	 * One NSGA-II generation with raw fitness and tree size as separate
+	 * objectives, in place of the weighted fitness.  Parents are drawn
+	 * by binary tournament in crowded-comparison order; the pop_.size()
+	 * children are evaluated, and the next generation is the best half
+	 * of parents and children together: whole fronts while they fit,
+	 * then the least crowded of the front that does not.  Every step is
+	 * O(n log n), and the losing trees are freed.
+	 */
+	Initialize();
+	size_t n = pop_.size();
+	rejected_crossovers_ = 0;
+	steady_state_ = false;
+	if (!crowded_selection_) {
+		crowded_selection_.reset(new TournamentSelection(1));
+	}
+	if (constant_opt_count_) {
+		OptimizeConstants();
+	}
+
+	RankPareto(pop_);
+	pareto_.CrowdedOrder(crowded_order_);
+	selection_fitness_.resize(n);
+	for (size_t k = 0; k < n; ++k) {
+		selection_fitness_[crowded_order_[k]] = static_cast<double>(k);
+	}
+	crowded_selection_->Prepare(selection_fitness_);
+	crowded_selection_->SelectParents(n, rng_, parents_);
+
+	offspring_.resize(n);
+	for (size_t j = 0; j < n; ++j) {
+		Individual parent1(pop_[parents_[j].first]);
+		Individual parent2(pop_[parents_[j].second]);
+		Crossover(&parent1, &parent2);
+		parent2.Erase();
+		parent1.Mutate(mutation_rate_, context_, operators_, rng_);
+		offspring_[j] = parent1;
+	}
+	std::vector<size_t> simplified(n);
+	static_scores_ = 0;
+	pool_->ParallelFor(n, [this, &simplified](size_t k) {
+		simplified[k] = EvaluateCandidate(offspring_[k], nullptr, 1,
+										  precision_, subtree_cache_.get());
+	});
+	simplified_nodes_ = 0;
+	for (auto count : simplified) {
+		simplified_nodes_ += count;
+	}
+
+	/* Index i < n is pop_[i], and n + j is offspring_[j] */
+	objective_error_.clear();
+	objective_size_.clear();
+	AppendObjectives(pop_);
+	AppendObjectives(offspring_);
 
-	size_t best, second;
-	best = 0;
-	second = 0;
+	/*
+	 * Copies share their objectives and never dominate each other, so
+	 * left alone a few tiny trees would fill the first front many times
+	 * over.  Any repeat of an earlier point is ranked behind every
+	 * distinct point instead.
+	 */
+	const double kInfinity = std::numeric_limits<double>::infinity();
+	std::set<std::pair<double, double>> distinct;
+	for (size_t i = 0; i < 2 * n; ++i) {
+		if (!distinct.insert(std::make_pair(objective_error_[i],
+											objective_size_[i])).second) {
+			objective_error_[i] = kInfinity;
+			objective_size_[i] = kInfinity;
+		}
+	}
+	pareto_.Rank(objective_error_, objective_size_);
+	std::vector<bool> kept(2 * n, false);
+	size_t survivors = 0;
+	for (size_t f = 0; f < pareto_.GetFrontCount() && survivors < n; ++f) {
+		std::vector<size_t> front = pareto_.GetFront(f);
+		if (survivors + front.size() > n) {
+			std::sort(front.begin(), front.end(), [this](size_t a, size_t b) {
+				return pareto_.GetCrowding(a) > pareto_.GetCrowding(b);
+			});
+			front.resize(n - survivors);
+		}
+		for (auto i : front) {
+			kept[i] = true;
+		}
+		survivors += front.size();
+	}
 
-	if (elitism_count % 2 != 0) {
-		++elitism_count; /* Force elites to be even */
+	/* Survivors are moved by plain assignment; the rest are freed */
+	survivors_.resize(n);
+	size_t next = 0;
+	for (size_t i = 0; i < 2 * n; ++i) {
+		Individual &individual = (i < n) ? pop_[i] : offspring_[i - n];
+		if (kept[i]) {
+			survivors_[next++] = individual;
+		} else {
+			individual.Erase();
+		}
 	}
+	pop_.swap(survivors_);
 
-	for (size_t i = 1; i < pop_.size(); ++i) {
-		if (pop_[i].GetFitness() < pop_[best].GetFitness()) {
-			best = i;
-		} else if (pop_[i].GetFitness() < pop_[second].GetFitness()) {
-			second = i;
+	RescoreBest();
+	skipped_evaluations_ = 0;
+	reused_evaluations_ = 0;
+	CalculateDiversity();
+	CalculateFitnessStats();
+	CalculateTreeSize();
+	CalculateWeightedFitness();
+	if (subtree_cache_) {
+		subtree_cache_->EndEpoch();
+	}
+}
+void Population::RankPareto(std::vector<Individual> &individuals) {
+	/* Non-dominated sort of individuals on raw fitness and tree size */
+	objective_error_.clear();
+	objective_size_.clear();
+	AppendObjectives(individuals);
+	pareto_.Rank(objective_error_, objective_size_);
+}
+void Population::AppendObjectives(std::vector<Individual> &individuals) {
+	for (auto &individual : individuals) {
+		objective_error_.push_back(individual.GetFitness());
+		objective_size_.push_back(
+			static_cast<double>(individual.GetTreeSize()));
+	}
+}
+void Population::SelectLosers(size_t count) {
+	/*
+	 * Inverse tournaments on weighted fitness (NaN loses to everything),
+	 * never picking the best individuals or the same loser twice.
+	 */
+	std::uniform_int_distribution<size_t> d{ 0,pop_.size() - 1 };
+	losers_.clear();
+	while (losers_.size() < count) {
+		size_t loser = d(rng_);
+		for (size_t i = 0; i < tournament_size_; ++i) {
+			size_t challenger = d(rng_);
+			double fc = selection_fitness_[challenger];
+			double fl = selection_fitness_[loser];
+			if (fc != fc || fc > fl) {
+				loser = challenger;
+			}
+		}
+		if (loser == best_index_ || loser == best_weighted_index_ ||
+			std::find(losers_.begin(), losers_.end(), loser) !=
+			losers_.end()) {
+			continue;
 		}
+		losers_.push_back(loser);
+	}
+}
+void Population::BuildIncrementalStats() {
+	/* Rebuilds the running stats from scratch; see TrackIndividual */
+	fitness_order_.clear();
+	weighted_order_.clear();
+	size_order_.clear();
+	depth_order_.clear();
+	fitness_sum_ = 0;
+	weighted_sum_ = 0;
+	nonfinite_fitness_ = 0;
+	nonfinite_weighted_ = 0;
+	node_sum_ = 0;
+	depth_sum_ = 0;
+	selection_fitness_.resize(pop_.size());
+	for (size_t i = 0; i < pop_.size(); ++i) {
+		selection_fitness_[i] = pop_[i].GetWeightedFitness();
+		TrackIndividual(i, true);
 	}
-	return std::vector<size_t>{best, second};
+	SyncIncrementalStats();
+}
+void Population::TrackIndividual(size_t i, bool add) {
+	/*
+	 * Adds pop_[i] to, or removes it from, the running stats.  Ordered
+	 * multisets give best/worst in O(log n); NaN is ordered as inf, and
+	 * sums only hold finite values so one inf cannot poison them.
+	 */
+	double fitness = pop_[i].GetFitness();
+	double weighted = pop_[i].GetWeightedFitness();
+	const double kInfinity = std::numeric_limits<double>::infinity();
+	double fitness_key = (fitness == fitness) ? fitness : kInfinity;
+	double weighted_key = (weighted == weighted) ? weighted : kInfinity;
+	size_t size = pop_[i].GetTreeSize();
+	size_t depth = pop_[i].GetTreeDepth();
+
+	if (add) {
+		fitness_order_.insert(fitness_key);
+		weighted_order_.insert(weighted_key);
+		size_order_.insert(size);
+		depth_order_.insert(depth);
+	} else {
+		fitness_order_.erase(fitness_order_.find(fitness_key));
+		weighted_order_.erase(weighted_order_.find(weighted_key));
+		size_order_.erase(size_order_.find(size));
+		depth_order_.erase(depth_order_.find(depth));
+	}
+	double sign = add ? 1 : -1;
+	if (std::isfinite(fitness)) {
+		fitness_sum_ += sign * fitness;
+	} else {
+		nonfinite_fitness_ += add ? 1 : -1;
+	}
+	if (std::isfinite(weighted)) {
+		weighted_sum_ += sign * weighted;
+	} else {
+		nonfinite_weighted_ += add ? 1 : -1;
+	}
+	node_sum_ = add ? node_sum_ + size : node_sum_ - size;
+	depth_sum_ = add ? depth_sum_ + depth : depth_sum_ - depth;
+}
+void Population::SyncIncrementalStats() {
+	/* Copies the running stats into the fields the getters report */
+	size_t n = pop_.size();
+	const double kInfinity = std::numeric_limits<double>::infinity();
+	best_fitness_ = *fitness_order_.begin();
+	worst_fitness_ = *fitness_order_.rbegin();
+	avg_fitness_ = nonfinite_fitness_ ? kInfinity : fitness_sum_ / n;
+	best_weighted_fitness_ = *weighted_order_.begin();
+	worst_weighted_fitness_ = *weighted_order_.rbegin();
+	avg_weighted_fitness_ = nonfinite_weighted_ ?
+		kInfinity : weighted_sum_ / n;
+	smallest_tree_ = *size_order_.begin();
+	largest_tree_ = *size_order_.rbegin();
+	deepest_tree_ = *depth_order_.rbegin();
+	total_nodes_ = node_sum_;
+	avg_tree_ = node_sum_ / n;
+	avg_depth_ = depth_sum_ / n;
+}
+
+/* Helper Functions */
+std::vector<size_t> Population::Elitism(size_t elitism_count) {
+	/*
+	 * This functions returns a vector of the indices of the
+	 * "elite_count" most fit individuals in the population, best first.
+	 */
+	if (elitism_count > pop_.size()) {
+		elitism_count = pop_.size();
+	}
+	std::vector<size_t> order(pop_.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+
+	/* NaN fitness sorts after everything else */
+	std::partial_sort(order.begin(), order.begin() + elitism_count,
+					  order.end(), [this](size_t a, size_t b) {
+		double fa = pop_[a].GetFitness();
+		double fb = pop_[b].GetFitness();
+		if (fa != fa) {
+			return false;
+		}
+		return fb != fb || fa < fb;
+	});
+	order.resize(elitism_count);
+	return order;
+}
+void Population::RescoreBest() {
+	/*
+	 * Single precision is only trusted for ranking.  The best
+	 * rescore_count_ are re-scored in double, and then whoever has the
+	 * lowest fitness is re-scored as well until that one is exact, so the
+	 * reported best fitness never comes from a float score.  The average
+	 * and worst fitness still may.
+	 */
+	if (precision_ != kSinglePrecision) {
+		return;
+	}
+	std::vector<bool> exact(pop_.size(), false);
+	for (auto i : Elitism(rescore_count_)) {
+		EvaluateIndividual(i, kDoublePrecision);
+		exact[i] = true;
+	}
+	for (size_t best = Elitism(1)[0]; !exact[best]; best = Elitism(1)[0]) {
+		EvaluateIndividual(best, kDoublePrecision);
+		exact[best] = true;
+	}
+}
+void Population::OptimizeConstants() {
+	/*
+	 * Tunes the constants of the best few individuals in place, one
+	 * individual per task.  Parents read from pop_ afterwards, so the
+	 * tuned constants are inherited.  A tuned individual is scored again
+	 * in double, as one of the best, so its fitness, case errors and
+	 * fingerprint all describe the new constants, and then the stats and
+	 * weighted fitness that selection reads are brought up to date.
+	 */
+	std::vector<size_t> best = Elitism(constant_opt_count_);
+	pool_->ParallelFor(best.size(), [this, &best](size_t i) {
+		Individual &tuned = pop_[best[i]];
+		if (tuned.OptimizeConstants(GetLocalData(),
+									constant_opt_iterations_)) {
+			tuned.CalculateFingerprint(probe_);
+			EvaluateIndividual(best[i], kDoublePrecision);
+		}
+	});
+	CalculateFitnessStats();
+	CalculateWeightedFitness();
 }
 void Population::CalculateFitness() {
 	/*
-	 * Calculating the weighted fitness first calculates the raw fitness 
-	 * in order to determine the parsimony coefficient that it needs. 
+	 * The weighted fitness needs the parsimony coefficient, which in turn
+	 * needs the raw fitness and size of every individual.
 	 */
+	CalculateRawFitness();
+	CalculateTreeSize();
 	CalculateWeightedFitness();
 }
 void Population::CalculateRawFitness() {
+	simplified_nodes_ = 0;
+	static_scores_ = 0;
+	if (track_case_errors_) {
+		case_errors_.Resize(pop_.size(), data_.GetRowCount());
+	}
+
+	/*
+	 * Individuals whose tree has not changed since they were last scored
+	 * (elites, and children that neither crossover nor mutation touched)
+	 * keep their fitness.  Per-case errors are stored by slot and slots
+	 * move between generations, so with those tracked every individual
+	 * is scored again.
+	 */
+	CalculateDiversity();
+	skipped_evaluations_ = 0;
+	reused_evaluations_ = 0;
+	std::vector<size_t> order;
+	order.reserve(pop_.size());
+	for (size_t i = 0; i < pop_.size(); ++i) {
+		if (share_duplicate_fitness_ && twin_of_[i] != i) {
+			++skipped_evaluations_;
+			continue;
+		}
+		if (!track_case_errors_ && !pop_[i].IsDirty()) {
+			++reused_evaluations_;
+			continue;
+		}
+		order.push_back(i);
+	}
+
+	/*
+	 * Largest trees first: the pool hands out indices one at a time, so
+	 * the long evaluations start early and the short ones fill the gaps
+	 * at the end instead of one big tree running on after the rest.
+	 */
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+		return pop_[a].GetTreeSize() > pop_[b].GetTreeSize();
+	});
+	if (row_tile_rows_ && data_.GetRowCount() > row_tile_rows_) {
+		simplified_nodes_ += EvaluateTiled(order, precision_);
+	} else {
+		std::vector<size_t> simplified(order.size());
+		pool_->ParallelFor(order.size(),
+						   [this, &order, &simplified](size_t k) {
+			simplified[k] = EvaluateIndividual(order[k], precision_);
+		});
+		for (auto n : simplified) {
+			simplified_nodes_ += n;
+		}
+	}
+
+	/* Twins take the fitness of the one that was evaluated */
+	if (share_duplicate_fitness_ && skipped_evaluations_) {
+		size_t cases = data_.GetRowCount();
+		const size_t stride = CaseErrorMatrix::kBlockSize;
+		for (size_t i = 0; i < pop_.size(); ++i) {
+			size_t original = twin_of_[i];
+			if (original == i) {
+				continue;
+			}
+			pop_[i].SetFitness(pop_[original].GetFitness());
+			if (track_case_errors_) {
+				const float *from = case_errors_.GetIndividual(original);
+				float *to = case_errors_.GetIndividual(i);
+				for (size_t c = 0; c < cases; ++c) {
+					to[c * stride] = from[c * stride];
+				}
+			}
+		}
+	}
+
+	RescoreBest();
+	CalculateFitnessStats();
+	if (subtree_cache_) {
+		subtree_cache_->EndEpoch();
+	}
+}
+void Population::CalculateFitnessStats() {
 	double cur_fitness = 0;
 	avg_fitness_ = 0;
 	best_fitness_ = DBL_MAX;
 	worst_fitness_ = DBL_MIN;
-
 	for (size_t i = 0; i < pop_.size(); ++i) {
-		pop_[i].CalculateFitness(solutions_);
 		cur_fitness = pop_[i].GetFitness();
 		avg_fitness_ += cur_fitness;
 		if (cur_fitness < best_fitness_) {
 			best_fitness_ = cur_fitness;
 			best_index_ = i;
-		} else if (cur_fitness > worst_fitness_) {
+		}
+		if (cur_fitness > worst_fitness_) {
 			worst_fitness_ = cur_fitness;
 		}
 	}
 	avg_fitness_ = avg_fitness_ / pop_.size();
 }
+void Population::CalculateDiversity() {
+	/*
+	 * Fingerprints every individual and records, for each, the first
+	 * individual with the same fingerprint (itself if it is the first),
+	 * and the first with an identical tree.  A fingerprint only looks at
+	 * a few probe rows, so that match is approximate; a twin is a hash
+	 * match confirmed node by node, so only twins share fitness.
+	 * Diversity is the fraction of distinct fingerprints and of distinct
+	 * tree structures.
+	 */
+	fingerprint_index_.clear();
+	structure_index_.clear();
+	duplicate_of_.resize(pop_.size());
+	twin_of_.resize(pop_.size());
+	for (size_t i = 0; i < pop_.size(); ++i) {
+		uint64_t fingerprint = pop_[i].CalculateFingerprint(probe_);
+		duplicate_of_[i] = fingerprint_index_.insert(
+			std::make_pair(fingerprint, i)).first->second;
+		size_t first = structure_index_.insert(
+			std::make_pair(pop_[i].Hash(), i)).first->second;
+		twin_of_[i] = (first != i && pop_[i].GetRootNode()->IsEqual(
+			pop_[first].GetRootNode())) ? first : i;
+	}
+	semantic_diversity_ = pop_.empty() ? 0 :
+		static_cast<double>(fingerprint_index_.size()) / pop_.size();
+	structural_diversity_ = pop_.empty() ? 0 :
+		static_cast<double>(structure_index_.size()) / pop_.size();
+}
+void Population::BuildNodeReplicas() {
+	/*
+	 * One owned copy of data_ per node, even when data_ is a view, each
+	 * made by a thread pinned to that node so its pages are allocated
+	 * there.  Only called while no evaluation is running.
+	 */
+	node_data_.clear();
+	if (!numa_aware_) {
+		return;
+	}
+	size_t node_count = numa_.GetNodeCount();
+	node_data_.resize(node_count);
+	for (size_t node = 0; node < node_count; ++node) {
+		numa_.RunOnNode(node, [this, node] {
+			node_data_[node].reset(new Dataset);
+			node_data_[node]->Assign(data_);
+		});
+	}
+}
+const Dataset& Population::GetLocalData() {
+	/* The calling thread's node copy of data_, or data_ if it has none */
+	size_t node = NumaTopology::GetCurrentNode();
+	return (node < node_data_.size()) ? *node_data_[node] : data_;
+}
+size_t Population::EvaluateIndividual(size_t i, Precision precision) {
+	/* Sets the raw fitness of pop_[i]; returns the nodes simplified away */
+	float *errors = nullptr;
+	if (track_case_errors_) {
+		errors = case_errors_.GetIndividual(i);
+	}
+	return EvaluateCandidate(pop_[i], errors, CaseErrorMatrix::kBlockSize,
+							 precision, subtree_cache_.get());
+}
+size_t Population::EvaluateCandidate(Individual &candidate,
+									 float *case_errors, size_t case_stride,
+									 Precision precision,
+									 SubtreeCache *cache) {
+	/*
+	 * Evaluates an individual that need not be in pop_ yet.  It only
+	 * reads shared state, so distinct candidates can be evaluated at
+	 * once from any thread.
+	 */
+	if (static_analysis_ && ScoreStatically(candidate, case_errors,
+			case_stride, precision, data_.GetRowCount())) {
+		return 0;
+	}
+	size_t simplified = 0;
+	switch (simplify_mode_) {
+	case kSimplifyCopy:
+		simplified = candidate.CalculateSimplifiedFitness(GetLocalData(),
+			case_errors, case_stride, precision, cache, block_evaluator_);
+		break;
+	case kSimplifyInPlace:
+		simplified = candidate.Simplify();
+		candidate.CalculateFitness(GetLocalData(), case_errors, case_stride,
+								   precision, cache, block_evaluator_);
+		break;
+	default:
+		candidate.CalculateFitness(GetLocalData(), case_errors, case_stride,
+								   precision, cache, block_evaluator_);
+		break;
+	}
+	return simplified;
+}
+bool Population::ScoreStatically(Individual &candidate, float *case_errors,
+								 size_t case_stride, Precision precision,
+								 size_t tile_rows) {
+	/*
+	 * Scores a tree the interval analysis settles without evaluating it:
+	 * one that gives the same value c on every row, finite, inf or NaN,
+	 * gets the error of predicting c everywhere, summed over tiles of
+	 * tile_rows just as evaluating it would be, so the fitness is the
+	 * same bit for bit and a seeded run does not depend on this stage.
+	 * The analysis works in double, so single precision always
+	 * evaluates.  Returns false if the tree must be evaluated.
+	 */
+	double constant = 0;
+	if (precision != kDoublePrecision ||
+		intervals_.Classify(candidate.GetRootNode(), constant) ==
+		kVaryingOutput) {
+		return false;
+	}
+	candidate.SetFitness(intervals_.ConstantError(constant, tile_rows));
+	if (case_errors) {
+		intervals_.ConstantCaseErrors(constant, case_errors, case_stride);
+	}
+	candidate.SetDirty(false);
+	++static_scores_;
+	return true;
+}
+size_t Population::EvaluateTiled(const std::vector<size_t> &order,
+								 Precision precision) {
+	/*
+	 * Sets the raw fitness of pop_[order[k]] for every k by splitting the
+	 * rows into tiles of row_tile_rows_ and handing out (individual, tile)
+	 * pairs one tile at a time, so a small population still keeps every
+	 * thread busy and the threads share one tile's columns in cache while
+	 * the individuals pass over it.  Each pair writes its own partial sum
+	 * and the partials are added in tile order, so the fitness does not
+	 * depend on the thread count.  Trees settled by the interval
+	 * analysis skip the tiles.  Returns the nodes simplified away.
+	 */
+	size_t n = order.size();
+	size_t rows = data_.GetRowCount();
+	size_t tiles = (rows + row_tile_rows_ - 1) / row_tile_rows_;
+
+	/* Simplify first, since every tile must see the same tree */
+	std::vector<Individual*> targets(n);
+	std::vector<size_t> simplified(n, 0);
+	pool_->ParallelFor(n, [this, &order, &targets, &simplified,
+						   precision](size_t k) {
+		Individual &individual = pop_[order[k]];
+		targets[k] = &individual;
+		float *errors = nullptr;
+		if (track_case_errors_) {
+			errors = case_errors_.GetIndividual(order[k]);
+		}
+		if (static_analysis_ && ScoreStatically(individual, errors,
+			CaseErrorMatrix::kBlockSize, precision, row_tile_rows_)) {
+			targets[k] = nullptr;
+		} else if (simplify_mode_ == kSimplifyCopy) {
+			targets[k] = new Individual(individual);
+			simplified[k] = targets[k]->Simplify();
+		} else if (simplify_mode_ == kSimplifyInPlace) {
+			simplified[k] = individual.Simplify();
+		}
+	});
+
+	std::vector<double> partial(n * tiles);
+	pool_->ParallelFor(n * tiles, [&](size_t job) {
+		size_t tile = job / n;
+		size_t k = job % n;
+		if (!targets[k]) {
+			return;
+		}
+		size_t begin = tile * row_tile_rows_;
+		size_t count = std::min(row_tile_rows_, rows - begin);
+		float *errors = nullptr;
+		if (track_case_errors_) {
+			errors = case_errors_.GetIndividual(order[k]);
+		}
+		partial[k * tiles + tile] = targets[k]->CalculateSquaredError(
+			GetLocalData(), begin, count, errors, CaseErrorMatrix::kBlockSize,
+			precision, subtree_cache_.get(), block_evaluator_);
+	});
+
+	size_t simplified_total = 0;
+	for (size_t k = 0; k < n; ++k) {
+		if (!targets[k]) {
+			continue;
+		}
+		double error = 0;
+		for (size_t tile = 0; tile < tiles; ++tile) {
+			error += partial[k * tiles + tile];
+		}
+		pop_[order[k]].SetFitness(sqrt(error / rows));
+		pop_[order[k]].SetDirty(false);
+		if (targets[k] != &pop_[order[k]]) {
+			targets[k]->Erase();
+			delete targets[k];
+		}
+		simplified_total += simplified[k];
+	}
+	return simplified_total;
+}
 void Population::CalculateWeightedFitness() {
 	/*
 	* This calculates both the raw fitness score and the weighted fitness
@@ -230,91 +1157,212 @@ void Population::CalculateWeightedFitness() {
 	worst_weighted_fitness_ = DBL_MIN;
 
 	for (size_t i = 0; i < pop_.size(); ++i) {
-
-		/* Fake parsimony pressure for now. */
-		if (pop_[i].GetTreeSize() > 100) {
-			parsimony_coefficient = 2;
-		} else {
-			parsimony_coefficient = 0;
-		}
-
 		pop_[i].CalculateWeightedFitness(parsimony_coefficient);
+		if (duplicate_policy_ == kDuplicatesPenalized &&
+			duplicate_of_[i] != i) {
+			pop_[i].SetWeightedFitness(pop_[i].GetWeightedFitness() *
+									   (1 + duplicate_penalty_));
+		}
 		cur_weighted_fitness = pop_[i].GetWeightedFitness();
 		avg_weighted_fitness_ += cur_weighted_fitness;
 		if (cur_weighted_fitness < best_weighted_fitness_) {
 			best_weighted_fitness_ = cur_weighted_fitness;
 			best_weighted_index_ = i;
-		} else if (cur_weighted_fitness > worst_weighted_fitness_) {
+		}
+		if (cur_weighted_fitness > worst_weighted_fitness_) {
 			worst_weighted_fitness_ = cur_weighted_fitness;
 		}
 	}
 	avg_weighted_fitness_ = avg_weighted_fitness_ / pop_.size();
 }
 double Population::CalculateParsimonyCoefficient() {
+	/*
+	 * Covariant parsimony pressure (Poli & McPhee): weighting fitness by
+	 * c * size with c = -Cov(size, fitness) / Var(size) holds the expected
+	 * mean tree size steady.  RMSE is heavy tailed, and a handful of
+	 * exploding individuals would swamp the covariance, so non-finite
+	 * fitness is left out and the rest is clipped at the 90th percentile.
+	 * A negative coefficient would reward growth, so it is clamped to zero.
+	 */
+	const double kClipQuantile = 0.9;
+	double size_mean = 0;
+	double fitness_mean = 0;
 	double covariance = 0;
 	double variance = 0;
 
-	CalculateRawFitness();
-	CalculateTreeSize();
-	
-	/*
+	parsimony_fitness_.clear();
 	for (size_t i = 0; i < pop_.size(); ++i) {
-		double cov = static_cast<double>((pop_[i].GetTreeSize() - avg_tree_));
-		double var = cov * cov;
-		cov *= (pop_[i].GetFitness() - avg_fitness_);
-		covariance += (cov / pop_.size());
-		variance += (var / pop_.size());
+		if (std::isfinite(pop_[i].GetFitness())) {
+			parsimony_fitness_.push_back(pop_[i].GetFitness());
+		}
+	}
+	size_t count = parsimony_fitness_.size();
+	if (count < 2) {
+		parsimony_coefficient_ = 0;
+		return parsimony_coefficient_;
 	}
+	auto clip = parsimony_fitness_.begin() +
+		static_cast<size_t>(kClipQuantile * (count - 1));
+	std::nth_element(parsimony_fitness_.begin(), clip,
+					 parsimony_fitness_.end());
+	double fitness_cap = *clip;
 
-	return covariance / variance;
-	*/
+	for (size_t i = 0; i < pop_.size(); ++i) {
+		double fitness = pop_[i].GetFitness();
+		if (!std::isfinite(fitness)) {
+			continue;
+		}
+		size_mean += static_cast<double>(pop_[i].GetTreeSize());
+		fitness_mean += std::min(fitness, fitness_cap);
+	}
+	size_mean /= count;
+	fitness_mean /= count;
 
-	return 1.0f;
+	for (size_t i = 0; i < pop_.size(); ++i) {
+		double fitness = pop_[i].GetFitness();
+		if (!std::isfinite(fitness)) {
+			continue;
+		}
+		double size_diff = pop_[i].GetTreeSize() - size_mean;
+		covariance += size_diff * (std::min(fitness, fitness_cap) -
+								   fitness_mean);
+		variance += size_diff * size_diff;
+	}
+	
+	if (variance == 0 || covariance >= 0) {
+		parsimony_coefficient_ = 0;
+	} else {
+		parsimony_coefficient_ = -covariance / variance;
+	}
+	return parsimony_coefficient_;
 }
 void Population::CalculateTreeSize() {
 	size_t cur_tree = 0;
+	size_t cur_depth = 0;
 	avg_tree_ = 0;
-	for (auto p : pop_) {
+	avg_depth_ = 0;
+	largest_tree_ = 0;
+	smallest_tree_ = SIZE_MAX;
+	deepest_tree_ = 0;
+	for (auto &p : pop_) {
 		cur_tree = p.GetTreeSize();
+		cur_depth = p.GetTreeDepth();
 		avg_tree_ += cur_tree;
+		avg_depth_ += cur_depth;
 		if (cur_tree > largest_tree_) {
 			largest_tree_ = cur_tree;
-		} else if (cur_tree < smallest_tree_) {
+		}
+		if (cur_tree < smallest_tree_) {
 			smallest_tree_ = cur_tree;
 		}
+		if (cur_depth > deepest_tree_) {
+			deepest_tree_ = cur_depth;
+		}
 	}
 	total_nodes_ = avg_tree_;
 	avg_tree_ = avg_tree_ / pop_.size(); /* Will truncate, I don't care */
+	avg_depth_ = avg_depth_ / pop_.size();
 }
 std::string Population::ToString(bool include_fitness) {
-	std::stringstream ss;
+	std::string out;
+	Render(out, include_fitness, kInfix);
+	return out;
+}
+std::string Population::GetBestSolutionToString(bool include_fitness,
+												bool latex) {
+	std::string out;
+	RenderBestSolution(out, include_fitness, latex ? kLatex : kInfix);
+	return out;
+}
+std::string Population::GetBestWeightedSolutionToString(bool include_fitness,
+														bool latex) {
+	std::string out;
+	RenderBestWeightedSolution(out, include_fitness,
+							   latex ? kLatex : kInfix);
+	return out;
+}
+void Population::Render(std::string &out, bool include_fitness,
+						RenderFormat format) {
+	/* Appends every individual to out, one per line */
+	Initialize();
 	for (auto &p : pop_) {
 		if (include_fitness) {
-			ss << p.GetFitness() << " ==> ";
+			AppendDouble(out, p.GetFitness());
+			out.append(" ==> ");
 		}
-		ss << p.ToString(false) << "\n";
+		p.Render(out, format);
+		out.push_back('\n');
 	}
-	return ss.str();
 }
-std::string Population::GetBestSolutionToString(bool include_fitness,
-												bool latex) {
-	std::stringstream ss;
-
+void Population::RenderBestSolution(std::string &out, bool include_fitness,
+									RenderFormat format) {
+	Initialize();
 	if (include_fitness) {
-		ss << pop_[best_index_].GetFitness() << " ==> ";
+		AppendDouble(out, pop_[best_index_].GetFitness());
+		out.append(" ==> ");
 	}
-	ss << pop_[best_index_].ToString(latex);
-	return ss.str();
+	pop_[best_index_].Render(out, format);
 }
-std::string Population::GetBestWeightedSolutionToString(bool include_fitness,
-														bool latex) {
-	std::stringstream ss;
-
+void Population::RenderBestWeightedSolution(std::string &out,
+											bool include_fitness,
+											RenderFormat format) {
+	Initialize();
 	if (include_fitness) {
-		ss << pop_[best_weighted_index_].GetWeightedFitness() << " ==> ";
+		AppendDouble(out, pop_[best_weighted_index_].GetWeightedFitness());
+		out.append(" ==> ");
 	}
-	ss << pop_[best_weighted_index_].ToString(latex);
-	return ss.str();
+	pop_[best_weighted_index_].Render(out, format);
+}
+uint64_t Population::GetBestSolutionHash() {
+	Initialize();
+	return pop_[best_index_].Hash();
+}
+bool Population::SaveBestModel(const std::string &filename) {
+	Initialize();
+	return Model::Save(filename, pop_[best_index_], data_.GetColumnCount());
+}
+bool Population::GetBestModel(Model &model) {
+	/* The same expression SaveBestModel writes, without the file */
+	Initialize();
+	std::string prefix;
+	pop_[best_index_].Render(prefix, kPrefix);
+	return model.Parse(prefix, data_.GetColumnCount());
+}
+bool Population::SaveParetoFront(const std::string &filename) {
+	/*
+	 * Writes the non-dominated individuals of the current population as
+	 * CSV, smallest first, one per distinct (size, fitness) pair.  The
+	 * prefix column is in the same form a model file holds.
+	 */
+	Initialize();
+	RankPareto(pop_);
+	const std::vector<size_t> &front = pareto_.GetFront(0);
+	std::string out("size,fitness,prefix\n");
+	size_t last = SIZE_MAX;
+	for (size_t k = front.size(); k-- > 0; ) {
+		/* A front runs from most accurate to smallest */
+		size_t i = front[k];
+		if (last != SIZE_MAX &&
+			objective_error_[i] == objective_error_[last] &&
+			objective_size_[i] == objective_size_[last]) {
+			continue;
+		}
+		last = i;
+		AppendSize(out, pop_[i].GetTreeSize());
+		out.push_back(',');
+		AppendDouble(out, pop_[i].GetFitness());
+		out.push_back(',');
+		pop_[i].Render(out, kPrefix);
+		out.push_back('\n');
+	}
+
+	std::ofstream outf(filename, std::ofstream::out | std::ofstream::trunc);
+	if (!outf) {
+		std::cerr << "Failed to open file: " << filename << std::endl;
+		return false;
+	}
+	outf << out;
+	return static_cast<bool>(outf);
 }
 
 /* Private Accessor Functions */
@@ -330,6 +1378,18 @@ size_t Population::GetAverageTreeSize() {
 size_t Population::GetTotalNodeCount() {
 	return total_nodes_;
 }
+size_t Population::GetDeepestTreeDepth() {
+	return deepest_tree_;
+}
+size_t Population::GetAverageTreeDepth() {
+	return avg_depth_;
+}
+size_t Population::GetRejectedCrossoverCount() {
+	return rejected_crossovers_;
+}
+double Population::GetParsimonyCoefficient() {
+	return parsimony_coefficient_;
+}
 double Population::GetBestFitness() {
 	return best_fitness_;
 }
@@ -347,4 +1407,206 @@ double Population::GetWorstWeightedFitness() {
 }
 double Population::GetAverageWeightedFitness() {
 	return avg_weighted_fitness_;
+}
+size_t Population::GetSimplifiedNodeCount() {
+	return simplified_nodes_;
+}
+size_t Population::GetSkippedEvaluationCount() {
+	return skipped_evaluations_;
+}
+size_t Population::GetReusedEvaluationCount() {
+	return reused_evaluations_;
+}
+size_t Population::GetStaticScoreCount() {
+	return static_scores_;
+}
+size_t Population::GetRejectedDuplicateCount() {
+	return rejected_duplicates_;
+}
+double Population::GetSemanticDiversity() {
+	return semantic_diversity_;
+}
+double Population::GetStructuralDiversity() {
+	return structural_diversity_;
+}
+size_t Population::GetMemoryUsage() {
+	/* Bytes held by the individuals; see Individual::GetMemoryUsage */
+	size_t bytes = 0;
+	for (auto &p : pop_) {
+		bytes += p.GetMemoryUsage();
+	}
+	return bytes;
+}
+size_t Population::GetNumaNodeCount() {
+	/* Nodes with their own copy of the data; 1 when not NUMA aware */
+	return numa_aware_ ? node_data_.size() : 1;
+}
+size_t Population::GetSubtreeCacheUsage() {
+	return subtree_cache_ ? subtree_cache_->GetMemoryUsage() : 0;
+}
+double Population::GetSubtreeCacheHitRate() {
+	/* Fraction of subtree lookups answered from the cache so far */
+	if (!subtree_cache_ || !subtree_cache_->GetLookupCount()) {
+		return 0;
+	}
+	return static_cast<double>(subtree_cache_->GetHitCount()) /
+		subtree_cache_->GetLookupCount();
+}
+uint32_t Population::GetSeed() {
+	return seed_;
+}
+
+/* Private Mutator Functions */
+void Population::SetSimplifyMode(SimplifyMode simplify_mode) {
+	async_queue_.reset(); /* Children in flight follow the old settings */
+	simplify_mode_ = simplify_mode;
+	for (auto &p : pop_) {
+		p.SetDirty(true); /* Scored under the old settings */
+	}
+}
+void Population::SetTreeLimits(size_t size_limit, size_t depth_limit) {
+	tree_size_limit_ = size_limit;
+	tree_depth_limit_ = depth_limit;
+}
+void Population::SetConstantOptimization(size_t individual_count,
+										 size_t iterations) {
+	constant_opt_count_ = individual_count;
+	constant_opt_iterations_ = iterations;
+}
+void Population::SetPrecision(Precision precision, size_t rescore_count) {
+	/*
+	 * kSinglePrecision evaluates on a float copy of the data and then
+	 * re-scores the best rescore_count individuals in double, along with
+	 * whichever one is reported as best.
+	 */
+	async_queue_.reset(); /* Its workers read data_ */
+	precision_ = precision;
+	rescore_count_ = rescore_count;
+	for (auto &p : pop_) {
+		p.SetDirty(true); /* Scored under the old settings */
+	}
+	if (precision_ == kSinglePrecision && !data_.HasSinglePrecision()) {
+		data_.BuildSinglePrecision();
+		BuildNodeReplicas(); /* Again, to pick up the float copy */
+	}
+}
+void Population::SetDuplicateHandling(bool share_fitness,
+									  DuplicatePolicy policy,
+									  double penalty) {
+	/*
+	 * share_fitness skips evaluating an individual whose tree is identical
+	 * to an earlier one's this generation and copies its fitness, which
+	 * is then exact.  policy and penalty act on semantic duplicates, the
+	 * looser match by fingerprint.
+	 */
+	share_duplicate_fitness_ = share_fitness;
+	duplicate_policy_ = policy;
+	duplicate_penalty_ = penalty;
+}
+void Population::SetInitialization(InitializationType init_type,
+								   size_t size_min, size_t size_max,
+								   bool unique) {
+	/*
+	 * Takes effect when the population is first built.  Called after
+	 * that, it rebuilds and re-evaluates the population in place.
+	 * size_min and size_max bound the PTC2 target sizes.
+	 */
+	init_type_ = init_type;
+	init_size_min_ = std::max<size_t>(1, std::min(size_min, size_max));
+	init_size_max_ = std::max<size_t>(1, std::max(size_min, size_max));
+	unique_init_ = unique;
+	if (!initialized_) {
+		return;
+	}
+
+	for (auto &p : pop_) {
+		p.Erase();
+	}
+	pop_.clear();
+	InitializePopulation(initial_size_);
+	CalculateFitness();
+}
+void Population::SetThreadCount(size_t thread_count) {
+	async_queue_.reset();
+	pool_.reset(new ThreadPool(thread_count, numa_aware_ ? &numa_ : nullptr));
+}
+void Population::SetRowTiling(size_t tile_rows) {
+	/*
+	 * With tile_rows set, generational evaluation splits the rows into
+	 * tiles of that many rows whenever there is more than one.  A tile's
+	 * columns should fit in the L2 cache alongside the tree's scratch.
+	 */
+	row_tile_rows_ = tile_rows;
+}
+void Population::SetStaticAnalysis(bool enabled) {
+	/*
+	 * When enabled, trees that interval analysis proves constant or
+	 * non-finite over the training inputs are scored without evaluation.
+	 */
+	async_queue_.reset(); /* Children in flight follow the old settings */
+	static_analysis_ = enabled;
+}
+void Population::SetNumaPolicy(bool enabled) {
+	/*
+	 * When enabled on a machine with more than one NUMA node, each node
+	 * gets its own copy of the training data and the evaluation threads
+	 * are pinned across the nodes, so they read local memory instead of
+	 * crossing the interconnect.  Their per-thread scratch is then local
+	 * too, since a thread allocates it for itself.  With a single node
+	 * nothing changes.
+	 */
+	size_t thread_count = pool_->GetThreadCount();
+	async_queue_.reset();
+	pool_.reset();
+	numa_aware_ = enabled && numa_.GetNodeCount() > 1;
+	BuildNodeReplicas();
+	pool_.reset(new ThreadPool(thread_count, numa_aware_ ? &numa_ : nullptr));
+}
+void Population::SetSubtreeCache(size_t budget_bytes) {
+	/*
+	 * Keeps the outputs of evaluated subtrees of SubtreeCache::kMinNodes
+	 * or more nodes, up to budget_bytes in all, so a child reuses the
+	 * columns of whatever it inherited unchanged.  0 disables the cache.
+	 * Asynchronous workers never use it: their evaluations overlap the
+	 * points where old entries are freed.
+	 */
+	subtree_cache_.reset(budget_bytes ? new SubtreeCache(budget_bytes) :
+						 nullptr);
+}
+void Population::SetAsyncEvaluation(size_t in_flight, bool size_priority) {
+	/*
+	 * in_flight is how many children EvolveAsync keeps bred ahead of the
+	 * workers (0 means twice the thread count); size_priority starts the
+	 * largest queued trees first.  Children already queued are dropped.
+	 */
+	async_queue_.reset();
+	async_in_flight_ = in_flight;
+	async_size_priority_ = size_priority;
+}
+void Population::SetSelectionType(SelectionType selection_type) {
+	/*
+	 * Lexicase reads the per-case errors of the current population, so
+	 * switching to it mid-run re-evaluates to fill the matrix.
+	 */
+	async_queue_.reset();
+	track_case_errors_ = false;
+	switch (selection_type) {
+	case kTournamentSelection:
+		selection_.reset(new TournamentSelection(tournament_size_));
+		break;
+	case kProportionateSelection:
+		selection_.reset(new ProportionateSelection);
+		break;
+	case kLexicaseSelection:
+		selection_.reset(new LexicaseSelection(&case_errors_));
+		track_case_errors_ = true;
+		if (!pop_.empty()) {
+			CalculateFitness();
+		}
+		break;
+	default:
+		std::cerr << "Bad selection type!" << std::endl;
+		exit(EXIT_FAILURE);
+		break;
+	}
 }
\ No newline at end of file
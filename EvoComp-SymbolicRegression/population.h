@@ -22,68 +22,294 @@
 */
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility> /* std::pair */
 #include <vector>
+#include "case_error_matrix.h"
+#include "dataset.h"
+#include "evaluation_queue.h"
 #include "individual.h"
+#include "interval_analysis.h"
+#include "model.h"
+#include "node_context.h"
+#include "numa_topology.h"
+#include "operator_set.h"
+#include "pareto_ranking.h"
+#include "render_format.h"
+#include "selection.h"
+#include "subtree_cache.h"
+#include "thread_pool.h"
+
+/* How the population is simplified before evaluation */
+enum SimplifyMode {
+	kSimplifyOff = 0,
+	kSimplifyCopy = 1, /* Evaluate a simplified copy, genotype untouched */
+	kSimplifyInPlace = 2 /* Simplify the genotype itself */
+};
+
+/* How the initial population is built */
+enum InitializationType {
+	kRampedHalfAndHalf = 1,
+	kPTC2 = 2 /* Probabilistic tree creation with uniform target sizes */
+};
+
+/* What breeding does with children that duplicate another's semantics */
+enum DuplicatePolicy {
+	kDuplicatesAllowed = 0,
+	kDuplicatesPenalized = 1, /* Weighted fitness scaled by 1 + penalty */
+	kDuplicatesRejected = 2 /* Child is re-bred a few times */
+};
 
 class Population {
 public:
+	/*
+	 * A seed of 0 draws one from std::random_device.  Any other seed
+	 * replays: the same seed, settings and thread count give the same run
+	 * every time, including asynchronous evaluation.
+	 */
 	Population(size_t population_size, double mutation_rate,
 			   double nonterminal_crossover_rate, size_t tournament_size, 
 			   size_t depth_min, size_t depth_max,
 			   double const_min, double const_max, 
-			   size_t var_count, std::vector<SolutionData> solutions);
+			   size_t var_count,
+			   const std::vector<SolutionData> &solutions,
+			   const OperatorSet &operators = OperatorSet(),
+			   uint32_t seed = 0);
+	/* Trains on data as is, so a view's columns are never copied */
+	Population(size_t population_size, double mutation_rate,
+			   double nonterminal_crossover_rate, size_t tournament_size,
+			   size_t depth_min, size_t depth_max,
+			   double const_min, double const_max,
+			   size_t var_count, Dataset data,
+			   const OperatorSet &operators = OperatorSet(),
+			   uint32_t seed = 0);
+	~Population();
 	
 	/* Helper Functions */
 	std::string ToString(bool include_fitness = false);
 	std::string GetBestSolutionToString(bool include_fitness, bool latex);
 	std::string GetBestWeightedSolutionToString(bool include_fitness, 
 												bool latex);
+	void Render(std::string &out, bool include_fitness, RenderFormat format);
+	void RenderBestSolution(std::string &out, bool include_fitness,
+							RenderFormat format);
+	void RenderBestWeightedSolution(std::string &out, bool include_fitness,
+									RenderFormat format);
+	uint64_t GetBestSolutionHash();
+	bool SaveBestModel(const std::string &filename);
+	bool GetBestModel(Model &model);
+	bool SaveParetoFront(const std::string &filename);
 
 	/* Public Genetic Program Functions */
+	/*
+	 * Builds and scores the first generation once every Set call is
+	 * done.  Evolving or reading the trees does this on first use; until
+	 * then the statistics are those of an empty population.
+	 */
+	void Initialize();
 	void Evolve(size_t elitism_count = 2);
+	void EvolveSteadyState(size_t batch_size = 1);
+	void EvolveAsync(size_t replacement_count);
+	void EvolvePareto();
 	
 	/* Private Accessor Functions */
 	size_t GetLargestTreeSize();
 	size_t GetSmallestTreeSize();
 	size_t GetAverageTreeSize();
 	size_t GetTotalNodeCount();
+	size_t GetDeepestTreeDepth();
+	size_t GetAverageTreeDepth();
+	size_t GetRejectedCrossoverCount();
+	double GetParsimonyCoefficient();
 	double GetBestFitness();
 	double GetWorstFitness();
 	double GetAverageFitness();
 	double GetBestWeightedFitness();
 	double GetWorstWeightedFitness();
 	double GetAverageWeightedFitness();
+	size_t GetSimplifiedNodeCount();
+	size_t GetSkippedEvaluationCount();
+	size_t GetReusedEvaluationCount();
+	size_t GetStaticScoreCount();
+	size_t GetRejectedDuplicateCount();
+	double GetSemanticDiversity();
+	double GetStructuralDiversity();
+	size_t GetMemoryUsage();
+	size_t GetSubtreeCacheUsage();
+	double GetSubtreeCacheHitRate();
+	size_t GetNumaNodeCount();
+	uint32_t GetSeed();
+
+	/* Private Mutator Functions */
+	void SetSimplifyMode(SimplifyMode simplify_mode);
+	void SetTreeLimits(size_t size_limit, size_t depth_limit);
+	void SetSelectionType(SelectionType selection_type);
+	void SetConstantOptimization(size_t individual_count, size_t iterations);
+	void SetPrecision(Precision precision, size_t rescore_count);
+	void SetInitialization(InitializationType init_type, size_t size_min,
+						   size_t size_max, bool unique);
+	void SetDuplicateHandling(bool share_fitness, DuplicatePolicy policy,
+							  double penalty = 0);
+	void SetThreadCount(size_t thread_count);
+	void SetAsyncEvaluation(size_t in_flight, bool size_priority);
+	void SetRowTiling(size_t tile_rows);
+	void SetStaticAnalysis(bool enabled);
+	void SetSubtreeCache(size_t budget_bytes);
+	void SetNumaPolicy(bool enabled);
 private:
+	Population(const Population &) = delete;
+	Population& operator=(const Population &) = delete;
+
 	/* Private Genetic Program Functions */
-	void RampedHalfAndHalf(size_t population_size,
-						   size_t depth_min, size_t depth_max);
+	void InitializePopulation(size_t population_size);
+	void InitializeIndividual(size_t i, std::mt19937 &mt);
 	void MutatePopulation();
-	void Crossover(Individual *parent1, Individual *parent2);
+	bool Crossover(Individual *parent1, Individual *parent2);
 
 	/* Helper functions */
-	size_t SelectIndividual();
 	std::vector<size_t> Elitism(size_t elite_count);
+	void RescoreBest();
+	void OptimizeConstants();
 	void CalculateFitness();
 	void CalculateRawFitness();
+	void CalculateFitnessStats();
+	size_t EvaluateIndividual(size_t i, Precision precision);
+	size_t EvaluateCandidate(Individual &candidate, float *case_errors,
+							 size_t case_stride, Precision precision,
+							 SubtreeCache *cache);
+	bool ScoreStatically(Individual &candidate, float *case_errors,
+						 size_t case_stride, Precision precision,
+						 size_t tile_rows);
+	size_t EvaluateTiled(const std::vector<size_t> &order,
+						 Precision precision);
+	void CalculateDiversity();
+	void BuildNodeReplicas();
+	const Dataset& GetLocalData();
 	void CalculateWeightedFitness();
 	double CalculateParsimonyCoefficient();
 	void CalculateTreeSize();
+	void SelectLosers(size_t count);
+	void BuildIncrementalStats();
+	void TrackIndividual(size_t i, bool add);
+	void SyncIncrementalStats();
+	void AcceptChild(size_t slot);
+	void RefreshSteadyState();
+	void RankPareto(std::vector<Individual> &individuals);
+	void AppendObjectives(std::vector<Individual> &individuals);
 
 	/* Population Data */
 	std::vector<Individual> pop_;
-	std::vector<SolutionData> solutions_;
-	double const_min_;
-	double const_max_;
-	size_t var_count_;
+	size_t initial_size_; /* Built by Initialize() on first use */
+	bool initialized_;
+	Dataset data_; /* The training data, owned or a caller's view */
+	NumaTopology numa_; /* Declared before the threads that use it */
+	bool numa_aware_;
+	/* Owned copies of data_ built on each node, when NUMA aware */
+	std::vector<std::unique_ptr<Dataset>> node_data_;
+	OperatorSet operators_;
+	NodeContext context_; /* Shared by every tree in the population */
+	BlockEvaluator block_evaluator_; /* Specialized for data_, or null */
+	IntervalAnalysis intervals_; /* Column ranges of data_ */
+	bool static_analysis_;
+	std::atomic<size_t> static_scores_; /* Settled without evaluating */
+	std::unique_ptr<SubtreeCache> subtree_cache_; /* Null when disabled */
 	double mutation_rate_;
 	double nonterminal_crossover_rate_;
 	size_t tournament_size_;
+	SimplifyMode simplify_mode_;
+	InitializationType init_type_;
+	size_t depth_min_;
+	size_t depth_max_;
+	size_t init_size_min_; /* PTC2 target size range */
+	size_t init_size_max_;
+	bool unique_init_;
+	Precision precision_;
+	size_t rescore_count_; /* Re-scored in double after a float pass */
+	size_t row_tile_rows_; /* 0 evaluates each individual whole */
+	std::mt19937 rng_;
+	uint32_t seed_;
+	bool replay_; /* Seeded by the caller, so results are taken in order */
+	std::unique_ptr<ThreadPool> pool_;
+	size_t constant_opt_count_;
+	size_t constant_opt_iterations_;
+
+	/* Semantic Deduplication */
+	Dataset probe_; /* A few fixed rows the fingerprints are taken on */
+	bool share_duplicate_fitness_;
+	DuplicatePolicy duplicate_policy_;
+	double duplicate_penalty_;
+	std::vector<size_t> duplicate_of_; /* First with the same fingerprint */
+	std::vector<size_t> twin_of_; /* First with an identical tree */
+	std::unordered_map<uint64_t, size_t> fingerprint_index_;
+	std::unordered_map<uint64_t, size_t> structure_index_;
+	std::unordered_set<uint64_t> child_fingerprints_;
+
+	/* Selection Data, reused every generation */
+	std::unique_ptr<Selection> selection_;
+	std::vector<double> selection_fitness_;
+	std::vector<std::pair<size_t, size_t>> parents_;
+	bool track_case_errors_;
+	CaseErrorMatrix case_errors_;
+	size_t tree_size_limit_; /* 0 means unlimited */
+	size_t tree_depth_limit_; /* 0 means unlimited */
+
+	/* Pareto Data, reused every generation */
+	ParetoRanking pareto_;
+	std::unique_ptr<Selection> crowded_selection_;
+	std::vector<Individual> offspring_;
+	std::vector<Individual> survivors_;
+	std::vector<double> objective_error_;
+	std::vector<double> objective_size_;
+	std::vector<size_t> crowded_order_;
+
+	/* Steady-State Data; the running stats are only kept in that mode */
+	bool steady_state_;
+	size_t replacements_; /* Since the last full refresh */
+	std::vector<size_t> losers_;
+	std::vector<size_t> loser_simplified_;
+	std::multiset<double> fitness_order_;
+	std::multiset<double> weighted_order_;
+	std::multiset<size_t> size_order_;
+	std::multiset<size_t> depth_order_;
+	double fitness_sum_;
+	double weighted_sum_;
+	size_t nonfinite_fitness_;
+	size_t nonfinite_weighted_;
+	size_t node_sum_;
+	size_t depth_sum_;
+
+	/*
+	 * Asynchronous Evaluation Data; the queue's workers read data_ and
+	 * the evaluation settings, so it is declared after them and is torn
+	 * down first.
+	 */
+	size_t async_in_flight_;
+	bool async_size_priority_;
+	std::unique_ptr<EvaluationQueue> async_queue_;
 
 	/* Population Metadata */
 	size_t largest_tree_;
 	size_t smallest_tree_;
 	size_t avg_tree_;
 	size_t total_nodes_;
+	size_t simplified_nodes_;
+	size_t deepest_tree_;
+	size_t avg_depth_;
+	size_t rejected_crossovers_;
+	size_t skipped_evaluations_;
+	size_t reused_evaluations_; /* Unchanged since last scored */
+	size_t rejected_duplicates_;
+	double semantic_diversity_;
+	double structural_diversity_;
+	double parsimony_coefficient_;
+	std::vector<double> parsimony_fitness_;
 	size_t best_index_;
 	size_t best_weighted_index_;
 	double best_fitness_;
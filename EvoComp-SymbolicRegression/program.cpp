@@ -0,0 +1,306 @@
+/*
+* program.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Implementation of Program class and the specialized block evaluators
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "program.h"
+#include <algorithm> /* For std::fill */
+#include <cstdlib>
+#include <iostream> /* Only for errors */
+#include "operator_kernels.h"
+#include "operator_table.h"
+
+template <size_t InputCount, int Subset>
+static const double* EvaluateBlock(const Instruction *code, size_t length,
+								   const Dataset &data, size_t row_begin,
+								   size_t count, const double **slots,
+								   double *buffer);
+template <int Subset>
+static BlockEvaluator SelectForSubset(size_t input_count);
+template <int Op>
+static void ApplyBinary(const double **slots, size_t &top, double *buffer,
+						size_t count);
+template <int Op>
+static void ApplyUnary(const double **slots, size_t top, double *buffer,
+					   size_t count);
+static bool ApplyNonArithmetic(OpType op, const double **slots, size_t top,
+							   double *buffer, size_t count);
+static void UnsupportedOperator(OpType op);
+
+Program::Program() {
+	stack_size_ = 0;
+}
+void Program::Compile(Node *root) {
+	code_.clear();
+	constants_.clear();
+	stack_size_ = 0;
+	Emit(root, 1);
+	stack_.resize(stack_size_);
+	slots_.resize(stack_size_);
+}
+double Program::Evaluate(const double *vars) {
+	/*
+	 * Runs the code for one row of inputs.  Every OpType has a case, so
+	 * nothing is silently skipped, and the kernels are the same ones
+	 * Node::Evaluate uses, in the same order, so the results match it
+	 * exactly.
+	 */
+	double *top = stack_.data(); /* One past the top value */
+	for (const Instruction &step : code_) {
+		switch (step.op) {
+		case kConst:
+			*top++ = step.value;
+			break;
+		case kVar:
+			*top++ = vars[step.var_index];
+			break;
+		case kAdd:
+			--top;
+			top[-1] = Kernel<kAdd>::Apply(top[-1], top[0]);
+			break;
+		case kSub:
+			--top;
+			top[-1] = Kernel<kSub>::Apply(top[-1], top[0]);
+			break;
+		case kMult:
+			--top;
+			top[-1] = Kernel<kMult>::Apply(top[-1], top[0]);
+			break;
+		case kDiv:
+			--top;
+			top[-1] = Kernel<kDiv>::Apply(top[-1], top[0]);
+			break;
+		case kSin:
+			top[-1] = Kernel<kSin>::Apply(top[-1], 0.0);
+			break;
+		case kCos:
+			top[-1] = Kernel<kCos>::Apply(top[-1], 0.0);
+			break;
+		case kExp:
+			top[-1] = Kernel<kExp>::Apply(top[-1], 0.0);
+			break;
+		case kLog:
+			top[-1] = Kernel<kLog>::Apply(top[-1], 0.0);
+			break;
+		case kSqrt:
+			top[-1] = Kernel<kSqrt>::Apply(top[-1], 0.0);
+			break;
+		case kSquare:
+			top[-1] = Kernel<kSquare>::Apply(top[-1], 0.0);
+			break;
+		}
+	}
+	return stack_[0];
+}
+const double* Program::EvaluateBlock(BlockEvaluator evaluator,
+									 const Dataset &data, size_t row_begin,
+									 size_t count, double *buffer) {
+	return evaluator(code_.data(), code_.size(), data, row_begin, count,
+					 slots_.data(), buffer);
+}
+size_t Program::GetConstantCount() {
+	return constants_.size();
+}
+void Program::SetConstant(size_t index, double value) {
+	code_[constants_[index]].value = value;
+}
+
+/* Private Accessors */
+const Instruction* Program::GetCode() {
+	return code_.data();
+}
+size_t Program::GetLength() {
+	return code_.size();
+}
+size_t Program::GetStackSize() {
+	return stack_size_;
+}
+
+/* Private Helper Functions */
+void Program::Emit(Node *node, size_t depth) {
+	/*
+	 * Children first, then the node.  depth is the stack height once the
+	 * node's value is pushed; the right child sits one above the left.
+	 */
+	Instruction step;
+	step.op = node->GetOpType();
+	switch (step.op) {
+	case kConst:
+		step.value = node->GetConstValue();
+		constants_.push_back(code_.size());
+		break;
+	case kVar:
+		step.var_index = node->GetVarIndex();
+		break;
+	default:
+		Emit(node->GetLeftChild(), depth);
+		if (node->GetRightChild()) {
+			Emit(node->GetRightChild(), depth + 1);
+		}
+		step.value = 0;
+		break;
+	}
+	if (depth > stack_size_) {
+		stack_size_ = depth;
+	}
+	code_.push_back(step);
+}
+
+BlockEvaluator SelectBlockEvaluator(size_t input_count,
+									const OperatorSet &operators) {
+	bool arithmetic = true;
+	for (size_t i = 0; i < operators.GetFunctionCount(); ++i) {
+		OpType op = operators.GetFunction(i);
+		if (op != kAdd && op != kSub && op != kMult && op != kDiv) {
+			arithmetic = false;
+		}
+	}
+	if (arithmetic) {
+		return SelectForSubset<kArithmeticSubset>(input_count);
+	}
+	return SelectForSubset<kFullSubset>(input_count);
+}
+
+/* Helper Functions */
+template <int Subset>
+static BlockEvaluator SelectForSubset(size_t input_count) {
+	static const BlockEvaluator kTable[kMaxSpecializedInputs + 1] = {
+		nullptr,
+		EvaluateBlock<1, Subset>,
+		EvaluateBlock<2, Subset>,
+		EvaluateBlock<3, Subset>,
+		EvaluateBlock<4, Subset>,
+		EvaluateBlock<5, Subset>,
+		EvaluateBlock<6, Subset>,
+		EvaluateBlock<7, Subset>,
+		EvaluateBlock<8, Subset>,
+		EvaluateBlock<9, Subset>,
+		EvaluateBlock<10, Subset>,
+		EvaluateBlock<11, Subset>,
+		EvaluateBlock<12, Subset>,
+		EvaluateBlock<13, Subset>,
+		EvaluateBlock<14, Subset>,
+		EvaluateBlock<15, Subset>,
+		EvaluateBlock<16, Subset>
+	};
+	if (input_count > kMaxSpecializedInputs) {
+		return nullptr;
+	}
+	return kTable[input_count];
+}
+template <size_t InputCount, int Subset>
+static const double* EvaluateBlock(const Instruction *code, size_t length,
+								   const Dataset &data, size_t row_begin,
+								   size_t count, const double **slots,
+								   double *buffer) {
+	/*
+	 * slots[d] is stack entry d: a column of data, or block d of buffer.
+	 * The InputCount column pointers are loaded once per block into a
+	 * fixed-size array, and each case is a batch kernel with its operator
+	 * fixed at compile time.  The arithmetic subset has no code for the
+	 * other operators at all.  The kernels, and their order on each row,
+	 * are the ones Node::EvaluateBatch uses, so the results match it
+	 * exactly.
+	 */
+	const double *columns[InputCount];
+	for (size_t c = 0; c < InputCount; ++c) {
+		columns[c] = data.GetColumn<double>(c) + row_begin;
+	}
+	size_t top = 0; /* Entries on the stack */
+	for (const Instruction *step = code; step != code + length; ++step) {
+		switch (step->op) {
+		case kConst: {
+			double *out = buffer + top * count;
+			std::fill(out, out + count, step->value);
+			slots[top++] = out;
+			break;
+		}
+		case kVar:
+			slots[top++] = columns[step->var_index];
+			break;
+		case kAdd:
+			ApplyBinary<kAdd>(slots, top, buffer, count);
+			break;
+		case kSub:
+			ApplyBinary<kSub>(slots, top, buffer, count);
+			break;
+		case kMult:
+			ApplyBinary<kMult>(slots, top, buffer, count);
+			break;
+		case kDiv:
+			ApplyBinary<kDiv>(slots, top, buffer, count);
+			break;
+		default:
+			if (Subset != kFullSubset ||
+				!ApplyNonArithmetic(step->op, slots, top, buffer, count)) {
+				UnsupportedOperator(step->op);
+			}
+			break;
+		}
+	}
+	return slots[0];
+}
+template <int Op>
+static void ApplyBinary(const double **slots, size_t &top, double *buffer,
+						size_t count) {
+	/* The result replaces the left operand, in that entry's block */
+	--top;
+	double *out = buffer + (top - 1) * count;
+	ApplyBatch<Op, double>(slots[top - 1], slots[top], out, count);
+	slots[top - 1] = out;
+}
+template <int Op>
+static void ApplyUnary(const double **slots, size_t top, double *buffer,
+					   size_t count) {
+	double *out = buffer + (top - 1) * count;
+	ApplyBatch<Op, double>(slots[top - 1], nullptr, out, count);
+	slots[top - 1] = out;
+}
+static bool ApplyNonArithmetic(OpType op, const double **slots, size_t top,
+							   double *buffer, size_t count) {
+	switch (op) {
+	case kSin:
+		ApplyUnary<kSin>(slots, top, buffer, count);
+		return true;
+	case kCos:
+		ApplyUnary<kCos>(slots, top, buffer, count);
+		return true;
+	case kExp:
+		ApplyUnary<kExp>(slots, top, buffer, count);
+		return true;
+	case kLog:
+		ApplyUnary<kLog>(slots, top, buffer, count);
+		return true;
+	case kSqrt:
+		ApplyUnary<kSqrt>(slots, top, buffer, count);
+		return true;
+	case kSquare:
+		ApplyUnary<kSquare>(slots, top, buffer, count);
+		return true;
+	default:
+		return false;
+	}
+}
+static void UnsupportedOperator(OpType op) {
+	std::cerr << "Operator " << GetOperatorInfo(op).name
+			  << " is not in the block evaluator's operator subset"
+			  << std::endl;
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,102 @@
+/*
+* program.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for Program class - a tree compiled to flat postfix code, and
+* block evaluators specialized at compile time for the input count and
+* operator set
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "dataset.h"
+#include "node.h"
+#include "operator_set.h"
+#include "operator_types.h"
+
+/* One postfix step: push a terminal, or pop operands and push the result */
+struct Instruction {
+	union {
+		double value; /* kConst */
+		size_t var_index; /* kVar */
+	};
+	OpType op;
+};
+
+/* The operators a specialized evaluator has code for */
+enum OperatorSubset {
+	kArithmeticSubset = 1, /* + - * / only */
+	kFullSubset = 2
+};
+
+/*
+ * Runs length instructions over rows [row_begin, row_begin + count) of
+ * data and returns where the results are, like Node::EvaluateBatch.
+ * slots holds a pointer per stack entry and buffer a block of count
+ * values per stack entry.  An operator outside the evaluator's subset
+ * is a fatal error.
+ */
+typedef const double* (*BlockEvaluator)(const Instruction *code,
+										size_t length, const Dataset &data,
+										size_t row_begin, size_t count,
+										const double **slots,
+										double *buffer);
+
+/* Inputs are specialized up to this count; wider problems use Node */
+const size_t kMaxSpecializedInputs = 16;
+
+/*
+ * Picks the evaluator instantiated for input_count data columns and the
+ * smallest subset that covers operators.  Done once per run; returns
+ * nullptr when there is no specialization, in which case callers fall
+ * back to Node::EvaluateBatch.
+ */
+BlockEvaluator SelectBlockEvaluator(size_t input_count,
+									const OperatorSet &operators);
+
+class Program {
+public:
+	Program();
+
+	/* Flattens the tree; the tree is not referenced afterwards */
+	void Compile(Node *root);
+	double Evaluate(const double *vars);
+	/* buffer needs GetStackSize() blocks of count values */
+	const double* EvaluateBlock(BlockEvaluator evaluator, const Dataset &data,
+								size_t row_begin, size_t count,
+								double *buffer);
+
+	/* Constants are numbered left to right, as the tree's leaves are */
+	size_t GetConstantCount();
+	void SetConstant(size_t index, double value);
+
+	/* Private Accessors */
+	const Instruction* GetCode();
+	size_t GetLength();
+	size_t GetStackSize();
+private:
+	void Emit(Node *node, size_t depth);
+
+	std::vector<Instruction> code_;
+	std::vector<size_t> constants_; /* Positions of the kConst steps */
+	std::vector<double> stack_;
+	std::vector<const double*> slots_; /* For the block evaluators */
+	size_t stack_size_;
+};
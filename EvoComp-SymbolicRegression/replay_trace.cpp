@@ -0,0 +1,88 @@
+/*
+* replay_trace.cpp
+* UIdaho CS-572: Evolutionary Computation
+* ReplayTrace class - writes and compares per-generation golden traces.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "replay_trace.h"
+#include <iostream>
+
+bool ReplayTrace::Open(const std::string &filename) {
+	outf_.open(filename, std::ios::out | std::ios::trunc);
+	if (!outf_) {
+		std::cerr << "Failed to open file: " << filename << std::endl;
+		return false;
+	}
+	outf_ << "generation,best_fitness,avg_fitness,worst_fitness,"
+		  << "smallest_tree,largest_tree,avg_tree,avg_depth,"
+		  << "semantic_diversity,best_hash" << std::endl;
+	return true;
+}
+void ReplayTrace::Record(const GenerationStats &stats, uint64_t best_hash) {
+	/*
+	 * Every field sets its own base and float mode, so nothing depends on
+	 * the previous line, and the stream is left in its defaults
+	 */
+	outf_ << std::dec << std::defaultfloat << stats.generation << ","
+		  << std::hexfloat << stats.best_fitness << ","
+		  << stats.avg_fitness << "," << stats.worst_fitness << ","
+		  << std::defaultfloat << stats.smallest_tree << ","
+		  << stats.largest_tree << "," << stats.avg_tree << ","
+		  << stats.avg_depth << ","
+		  << std::hexfloat << stats.semantic_diversity << ","
+		  << std::hex << best_hash << std::dec << std::defaultfloat << "\n";
+}
+void ReplayTrace::Close() {
+	outf_ << std::flush;
+	outf_.close();
+}
+bool ReplayTrace::Compare(const std::string &golden,
+						  const std::string &trace) {
+	std::ifstream golden_file(golden);
+	std::ifstream trace_file(trace);
+	if (!golden_file) {
+		std::cerr << "Failed to open file: " << golden << std::endl;
+		return false;
+	}
+	if (!trace_file) {
+		std::cerr << "Failed to open file: " << trace << std::endl;
+		return false;
+	}
+
+	std::string expected;
+	std::string actual;
+	size_t line = 0;
+	for (;;) {
+		bool more_expected = static_cast<bool>(std::getline(golden_file,
+															expected));
+		bool more_actual = static_cast<bool>(std::getline(trace_file, actual));
+		++line;
+		if (!more_expected && !more_actual) {
+			return true;
+		}
+		if (more_expected != more_actual || expected != actual) {
+			std::cerr << "Traces differ at line " << line << ":" << std::endl
+					  << "  expected: " << (more_expected ? expected : "<end>")
+					  << std::endl
+					  << "  actual:   " << (more_actual ? actual : "<end>")
+					  << std::endl;
+			return false;
+		}
+	}
+}
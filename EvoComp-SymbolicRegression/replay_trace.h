@@ -0,0 +1,49 @@
+/*
+* replay_trace.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for ReplayTrace class - writes the per-generation golden trace
+* used to check that a seeded run replays exactly, and compares traces
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "generation_stats.h"
+
+/*
+ * One CSV line per generation: the statistics that summarize the run and
+ * the structural hash of the best individual.  Doubles are written as
+ * hex floats, so two traces only compare equal when every bit matches.
+ * A seeded run (see Population) writes the same trace on every build
+ * that evaluates identically, which makes a trace from a known-good
+ * build the golden trace for later ones.
+ */
+class ReplayTrace {
+public:
+	bool Open(const std::string &filename);
+	void Record(const GenerationStats &stats, uint64_t best_hash);
+	void Close();
+
+	/* Reports the first line where trace differs from golden */
+	static bool Compare(const std::string &golden, const std::string &trace);
+private:
+	std::ofstream outf_;
+};
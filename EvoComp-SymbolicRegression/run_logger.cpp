@@ -0,0 +1,109 @@
+/*
+* run_logger.cpp
+* UIdaho CS-572: Evolutionary Computation
+* RunLogger class - writes generation statistics to the run log on a
+* background thread.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "run_logger.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream> /* Only for errors */
+#include <utility> /* std::move */
+
+RunLogger::RunLogger(const std::string &filename, size_t capacity)
+	: slots_(capacity), head_(0), tail_(0), done_(false) {
+	output_file_.open(filename, std::ios::out | std::ios::trunc);
+	if (!output_file_) {
+		std::cerr << "Failed to open file: " << filename << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	output_file_ << "generation,best_fitness,worst_fitness,avg_fitness,"
+				 << "smallest_tree,largest_tree,avg_tree,deepest_tree,"
+				 << "avg_depth,rejected_crossovers,parsimony_coefficient,"
+				 << "semantic_diversity,structural_diversity,best_solution"
+				 << "\n";
+	writer_ = std::thread(&RunLogger::WriterLoop, this);
+}
+RunLogger::~RunLogger() {
+	Close();
+}
+void RunLogger::Push(GenerationStats &&stats) {
+	size_t tail = tail_.load(std::memory_order_relaxed);
+
+	/* Queue is full, so wait on the writer rather than drop a generation */
+	while (tail - head_.load(std::memory_order_acquire) >= slots_.size()) {
+		std::this_thread::yield();
+	}
+	slots_[tail % slots_.size()] = std::move(stats);
+	tail_.store(tail + 1, std::memory_order_release);
+}
+void RunLogger::Close() {
+	if (writer_.joinable()) {
+		done_.store(true, std::memory_order_release);
+		writer_.join();
+		output_file_.close();
+	}
+}
+
+/* Private Helper Functions */
+void RunLogger::WriterLoop() {
+	size_t head = head_.load(std::memory_order_relaxed);
+	for (;;) {
+		/* Read done_ first so nothing pushed before Close() is missed */
+		bool done = done_.load(std::memory_order_acquire);
+		size_t tail = tail_.load(std::memory_order_acquire);
+
+		if (head == tail) {
+			if (done) {
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		while (head != tail) {
+			WriteStats(slots_[head % slots_.size()]);
+			++head;
+			head_.store(head, std::memory_order_release);
+		}
+	}
+	output_file_.flush();
+}
+void RunLogger::WriteStats(const GenerationStats &stats) {
+	/* Columns in the order of the header row written on opening */
+	char delim = ',';
+
+	if (stats.best_changed) {
+		last_solution_ = stats.best_solution;
+	}
+	output_file_ << stats.generation << delim;
+	output_file_ << stats.best_fitness << delim;
+	output_file_ << stats.worst_fitness << delim;
+	output_file_ << stats.avg_fitness << delim;
+	output_file_ << stats.smallest_tree << delim;
+	output_file_ << stats.largest_tree << delim;
+	output_file_ << stats.avg_tree << delim;
+	output_file_ << stats.deepest_tree << delim;
+	output_file_ << stats.avg_depth << delim;
+	output_file_ << stats.rejected_crossovers << delim;
+	output_file_ << stats.parsimony_coefficient << delim;
+	output_file_ << stats.semantic_diversity << delim;
+	output_file_ << stats.structural_diversity << delim;
+	output_file_ << last_solution_ << "\n";
+}
@@ -0,0 +1,58 @@
+/*
+* run_logger.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for RunLogger class - writes generation statistics to the run log
+* on a background thread.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "generation_stats.h"
+
+class RunLogger {
+public:
+	RunLogger(const std::string &filename, size_t capacity = 1024);
+	~RunLogger();
+
+	/* Takes stats over; the caller refills it before the next Push */
+	void Push(GenerationStats &&stats);
+	void Close();
+private:
+	/* Private Helper Functions */
+	void WriterLoop();
+	void WriteStats(const GenerationStats &stats);
+
+	/*
+	 * Single producer/single consumer ring buffer.  The evolution thread
+	 * only advances tail_ and the writer thread only advances head_.
+	 */
+	std::vector<GenerationStats> slots_;
+	std::atomic<size_t> head_;
+	std::atomic<size_t> tail_;
+	std::atomic<bool> done_;
+
+	std::thread writer_;
+	std::ofstream output_file_;
+	std::string last_solution_;
+};
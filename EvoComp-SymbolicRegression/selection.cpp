@@ -0,0 +1,288 @@
+/*
+* selection.cpp
+* UIdaho CS-572: Evolutionary Computation
+* Parent selection schemes used by Population
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "selection.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static size_t PopCount(uint64_t x);
+
+void Selection::SelectParents(size_t pair_count, std::mt19937 &mt,
+	std::vector<std::pair<size_t, size_t>> &parents) {
+	parents.resize(pair_count);
+	for (auto &p : parents) {
+		p.first = Select(mt);
+		p.second = SelectOther(p.first, mt);
+	}
+}
+size_t Selection::SelectOther(size_t first, std::mt19937 &mt) {
+	/* Two distinct parents, unless the scheme only ever returns one */
+	const size_t kAttempts = 64;
+	size_t second = Select(mt);
+	for (size_t i = 0; i < kAttempts && second == first; ++i) {
+		second = Select(mt);
+	}
+	return second;
+}
+
+TournamentSelection::TournamentSelection(size_t tournament_size) {
+	tournament_size_ = tournament_size;
+}
+void TournamentSelection::Prepare(const std::vector<double> &fitness) {
+	fitness_ = fitness;
+}
+size_t TournamentSelection::Select(std::mt19937 &mt) {
+	std::uniform_int_distribution<size_t> d{ 0,fitness_.size() - 1 };
+	size_t winner = d(mt);
+
+	for (size_t i = 0; i < tournament_size_; ++i) {
+		size_t challenger = d(mt);
+		if (fitness_[challenger] < fitness_[winner]) {
+			winner = challenger;
+		}
+	}
+	return winner;
+}
+void TournamentSelection::SelectParents(size_t pair_count, std::mt19937 &mt,
+	std::vector<std::pair<size_t, size_t>> &parents) {
+	/*
+	 * Draw every entrant of every tournament up front, then run the
+	 * tournaments as one tight pass over the compact fitness array.
+	 */
+	const size_t entrants = tournament_size_ + 1;
+	std::uniform_int_distribution<size_t> d{ 0,fitness_.size() - 1 };
+
+	draws_.resize(2 * pair_count * entrants);
+	for (auto &draw : draws_) {
+		draw = d(mt);
+	}
+
+	parents.resize(pair_count);
+	const size_t *draw = draws_.data();
+	for (size_t i = 0; i < 2 * pair_count; ++i, draw += entrants) {
+		size_t winner = draw[0];
+		double best = fitness_[winner];
+		for (size_t j = 1; j < entrants; ++j) {
+			if (fitness_[draw[j]] < best) {
+				winner = draw[j];
+				best = fitness_[winner];
+			}
+		}
+		if (i % 2 == 0) {
+			parents[i / 2].first = winner;
+		} else if (winner != parents[i / 2].first) {
+			parents[i / 2].second = winner;
+		} else {
+			parents[i / 2].second = SelectOther(winner, mt);
+		}
+	}
+}
+
+void ProportionateSelection::Prepare(const std::vector<double> &fitness) {
+	/*
+	 * Fitness is an error, so each individual is weighted by
+	 * 1 / (1 + fitness); non-finite errors get no weight at all.
+	 */
+	size_t n = fitness.size();
+	double total = 0;
+
+	probability_.resize(n);
+	alias_.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		double f = fitness[i];
+		probability_[i] = (std::isfinite(f) && f >= 0) ? 1 / (1 + f) : 0;
+		total += probability_[i];
+	}
+	small_.clear();
+	large_.clear();
+	for (size_t i = 0; i < n; ++i) {
+		probability_[i] = (total > 0) ? probability_[i] * n / total : 1;
+		alias_[i] = i;
+		if (probability_[i] < 1) {
+			small_.push_back(i);
+		} else {
+			large_.push_back(i);
+		}
+	}
+	while (!small_.empty() && !large_.empty()) {
+		size_t s = small_.back();
+		size_t l = large_.back();
+		small_.pop_back();
+		large_.pop_back();
+
+		alias_[s] = l;
+		probability_[l] -= 1 - probability_[s];
+		if (probability_[l] < 1) {
+			small_.push_back(l);
+		} else {
+			large_.push_back(l);
+		}
+	}
+	/* Whatever is left over is 1 up to rounding error */
+	for (auto i : small_) {
+		probability_[i] = 1;
+	}
+	for (auto i : large_) {
+		probability_[i] = 1;
+	}
+}
+size_t ProportionateSelection::Select(std::mt19937 &mt) {
+	std::uniform_int_distribution<size_t> column{ 0,probability_.size() - 1 };
+	std::uniform_real_distribution<double> coin{ 0,1 };
+	size_t i = column(mt);
+	return (coin(mt) < probability_[i]) ? i : alias_[i];
+}
+
+LexicaseSelection::LexicaseSelection(const CaseErrorMatrix *errors) {
+	errors_ = errors;
+}
+void LexicaseSelection::Prepare(const std::vector<double> & /* fitness */) {
+	/*
+	 * Epsilon-lexicase ignores aggregate fitness; it only needs the
+	 * per-case epsilon, taken as the MAD of each column of the matrix.
+	 * Infinite errors are left out, since an inf median would turn every
+	 * deviation into NaN; a column with no finite error gets epsilon 0.
+	 */
+	const size_t kBlockSize = CaseErrorMatrix::kBlockSize;
+	size_t n = errors_->GetIndividualCount();
+	size_t cases = errors_->GetCaseCount();
+
+	epsilon_.resize(cases);
+	column_.resize(n);
+	for (size_t c = 0; c < cases; ++c) {
+		size_t m = 0;
+		for (size_t i = 0; i < n; ++i) {
+			float e = errors_->GetBlock(i / kBlockSize, c)[i % kBlockSize];
+			if (std::isfinite(e)) {
+				column_[m++] = e;
+			}
+		}
+		if (m == 0) {
+			epsilon_[c] = 0;
+			continue;
+		}
+		std::nth_element(column_.begin(), column_.begin() + m / 2,
+						 column_.begin() + m);
+		float median = column_[m / 2];
+		for (size_t i = 0; i < m; ++i) {
+			column_[i] = std::fabs(column_[i] - median);
+		}
+		std::nth_element(column_.begin(), column_.begin() + m / 2,
+						 column_.begin() + m);
+		epsilon_[c] = std::isfinite(column_[m / 2]) ? column_[m / 2] : 0;
+	}
+
+	case_order_.resize(cases);
+	for (size_t c = 0; c < cases; ++c) {
+		case_order_[c] = c;
+	}
+}
+size_t LexicaseSelection::Select(std::mt19937 &mt) {
+	const size_t kBlockSize = CaseErrorMatrix::kBlockSize;
+	const float kInf = std::numeric_limits<float>::infinity();
+	size_t n = errors_->GetIndividualCount();
+	size_t cases = case_order_.size();
+	size_t survivor_count = n;
+
+	/* Everyone starts out as a survivor */
+	survivors_.assign(errors_->GetBlockCount(), ~0ULL);
+	if (n % kBlockSize) {
+		survivors_.back() = (1ULL << (n % kBlockSize)) - 1;
+	}
+	active_words_.resize(survivors_.size());
+	for (size_t w = 0; w < active_words_.size(); ++w) {
+		active_words_[w] = w;
+	}
+
+	for (size_t k = 0; k < cases && survivor_count > 1; ++k) {
+		/* One more step of a Fisher-Yates shuffle of the case order */
+		std::uniform_int_distribution<size_t> pick{ k,cases - 1 };
+		std::swap(case_order_[k], case_order_[pick(mt)]);
+		size_t c = case_order_[k];
+
+		/* Best error on this case among the survivors */
+		float best = kInf;
+		for (auto w : active_words_) {
+			const float *e = errors_->GetBlock(w, c);
+			uint64_t bits = survivors_[w];
+			for (size_t j = 0; j < kBlockSize; ++j) {
+				float v = ((bits >> j) & 1) ? e[j] : kInf;
+				best = (v < best) ? v : best;
+			}
+		}
+		if (!(best < kInf)) {
+			continue; /* Nobody is finite on this case, so skip it */
+		}
+
+		/* Keep only those within epsilon of it, the best at least */
+		float threshold = best + epsilon_[c];
+		size_t remaining = 0;
+		keep_.resize(active_words_.size());
+		for (size_t a = 0; a < active_words_.size(); ++a) {
+			const float *e = errors_->GetBlock(active_words_[a], c);
+			uint64_t keep = 0;
+			for (size_t j = 0; j < kBlockSize; ++j) {
+				keep |= static_cast<uint64_t>(e[j] <= threshold) << j;
+			}
+			keep_[a] = survivors_[active_words_[a]] & keep;
+			remaining += PopCount(keep_[a]);
+		}
+		size_t active = 0;
+		for (size_t a = 0; a < active_words_.size(); ++a) {
+			survivors_[active_words_[a]] = keep_[a];
+			if (keep_[a]) {
+				active_words_[active++] = active_words_[a];
+			}
+		}
+		active_words_.resize(active);
+		survivor_count = remaining;
+	}
+
+	/* Uniformly pick one of whoever is left */
+	std::uniform_int_distribution<size_t> d{ 0,survivor_count - 1 };
+	size_t target = d(mt);
+	for (auto w : active_words_) {
+		size_t count = PopCount(survivors_[w]);
+		if (target >= count) {
+			target -= count;
+			continue;
+		}
+		uint64_t bits = survivors_[w];
+		for (size_t j = 0; j < kBlockSize; ++j) {
+			if ((bits >> j) & 1) {
+				if (target == 0) {
+					return w * kBlockSize + j;
+				}
+				--target;
+			}
+		}
+	}
+	return 0;
+}
+
+static size_t PopCount(uint64_t x) {
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return static_cast<size_t>((x * 0x0101010101010101ULL) >> 56);
+}
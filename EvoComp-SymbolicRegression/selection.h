@@ -0,0 +1,101 @@
+/*
+* selection.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for the parent selection schemes used by Population
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility> /* std::pair */
+#include <vector>
+#include "case_error_matrix.h"
+
+enum SelectionType {
+	kTournamentSelection = 1,
+	kProportionateSelection = 2,
+	kLexicaseSelection = 3
+};
+
+/*
+ * A selection scheme is prepared once per generation with the weighted
+ * fitness of every individual (lower is better), gathered into one
+ * contiguous array, and then hands back indices into that array.
+ */
+class Selection {
+public:
+	virtual ~Selection() {}
+
+	virtual void Prepare(const std::vector<double> &fitness) = 0;
+	virtual size_t Select(std::mt19937 &mt) = 0;
+	virtual void SelectParents(size_t pair_count, std::mt19937 &mt,
+		std::vector<std::pair<size_t, size_t>> &parents);
+protected:
+	size_t SelectOther(size_t first, std::mt19937 &mt);
+};
+
+class TournamentSelection : public Selection {
+public:
+	TournamentSelection(size_t tournament_size);
+
+	void Prepare(const std::vector<double> &fitness);
+	size_t Select(std::mt19937 &mt);
+	void SelectParents(size_t pair_count, std::mt19937 &mt,
+		std::vector<std::pair<size_t, size_t>> &parents);
+private:
+	size_t tournament_size_;
+	std::vector<double> fitness_;
+	std::vector<size_t> draws_;
+};
+
+class ProportionateSelection : public Selection {
+public:
+	void Prepare(const std::vector<double> &fitness);
+	size_t Select(std::mt19937 &mt);
+private:
+	/* Walker/Vose alias table: O(n) to build, O(1) per draw */
+	std::vector<double> probability_;
+	std::vector<size_t> alias_;
+	std::vector<size_t> small_;
+	std::vector<size_t> large_;
+};
+
+class LexicaseSelection : public Selection {
+public:
+	LexicaseSelection(const CaseErrorMatrix *errors);
+
+	void Prepare(const std::vector<double> &fitness);
+	size_t Select(std::mt19937 &mt);
+private:
+	const CaseErrorMatrix *errors_;
+
+	/* Per-case epsilon: median absolute deviation of the errors */
+	std::vector<float> epsilon_;
+	std::vector<float> column_;
+
+	/* Case order, shuffled lazily only as far as each selection reads it */
+	std::vector<size_t> case_order_;
+
+	/* Survivor bitset and the indices of its non-zero words */
+	std::vector<uint64_t> survivors_;
+	std::vector<size_t> active_words_;
+	std::vector<uint64_t> keep_;
+};
@@ -0,0 +1,121 @@
+/*
+* subtree_cache.cpp
+* UIdaho CS-572: Evolutionary Computation
+* SubtreeCache class - shares evaluated subtree outputs between individuals.
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "subtree_cache.h"
+
+SubtreeCache::SubtreeCache(size_t budget_bytes)
+	: budget_bytes_(budget_bytes), used_bytes_(0), epoch_(0) {
+	for (auto &shard : shards_) {
+		shard.hits = 0;
+		shard.lookups = 0;
+	}
+}
+const double* SubtreeCache::Find(uint64_t hash, uint64_t check,
+								 size_t node_count, size_t row_begin,
+								 size_t count) {
+	Shard &shard = GetShard(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	++shard.lookups;
+	auto it = shard.entries.find(Key{ hash, row_begin });
+	if (it == shard.entries.end() || it->second.check != check ||
+		it->second.node_count != node_count ||
+		it->second.values.size() != count) {
+		return nullptr;
+	}
+	++shard.hits;
+	it->second.last_epoch = epoch_;
+	return it->second.values.data();
+}
+void SubtreeCache::Insert(uint64_t hash, uint64_t check,
+						  size_t node_count, size_t row_begin, size_t count,
+						  const double *values) {
+	size_t bytes = count * sizeof(double) + kEntryOverhead;
+	if (used_bytes_.fetch_add(bytes) + bytes > budget_bytes_) {
+		used_bytes_ -= bytes;
+		return;
+	}
+	Shard &shard = GetShard(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto inserted = shard.entries.emplace(Key{ hash, row_begin }, Entry());
+	if (!inserted.second) {
+		used_bytes_ -= bytes; /* Another thread got there first */
+		return;
+	}
+	Entry &entry = inserted.first->second;
+	entry.check = check;
+	entry.node_count = node_count;
+	entry.last_epoch = epoch_;
+	entry.values.assign(values, values + count);
+}
+void SubtreeCache::EndEpoch() {
+	/*
+	 * A subtree last used one epoch ago may belong to an individual that
+	 * was not re-evaluated this time (an elite, say) but still breeds, so
+	 * it survives one more.
+	 */
+	for (auto &shard : shards_) {
+		for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+			if (epoch_ - it->second.last_epoch >= 2) {
+				used_bytes_ -= it->second.values.size() * sizeof(double) +
+					kEntryOverhead;
+				it = shard.entries.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+	++epoch_;
+}
+
+/* Private Accessors */
+size_t SubtreeCache::GetMemoryUsage() {
+	return used_bytes_;
+}
+size_t SubtreeCache::GetHitCount() {
+	size_t hits = 0;
+	for (auto &shard : shards_) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		hits += shard.hits;
+	}
+	return hits;
+}
+size_t SubtreeCache::GetLookupCount() {
+	size_t lookups = 0;
+	for (auto &shard : shards_) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		lookups += shard.lookups;
+	}
+	return lookups;
+}
+
+/* Private Helper Functions */
+bool SubtreeCache::Key::operator==(const Key &other) const {
+	return hash == other.hash && row_begin == other.row_begin;
+}
+size_t SubtreeCache::KeyHash::operator()(const Key &key) const {
+	/* The structural hash is already well mixed */
+	return static_cast<size_t>(key.hash ^
+							   (key.row_begin * 0x9e3779b97f4a7c15ULL));
+}
+SubtreeCache::Shard& SubtreeCache::GetShard(uint64_t hash) {
+	return shards_[(hash >> 59) % kShardCount];
+}
@@ -0,0 +1,100 @@
+/*
+* subtree_cache.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for SubtreeCache class - shares evaluated subtree outputs between
+* individuals, so a child only recomputes what crossover changed
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Output columns of evaluated subtrees, keyed by structural hash and row
+ * block.  A child of crossover is its parents' subtrees joined along one
+ * new path, so once the parents have been evaluated, every subtree off
+ * that path is found here and only the path itself is recomputed.
+ *
+ * Lookups and inserts may come from any thread.  Entries are never
+ * moved or freed while evaluations are running, so a returned column
+ * stays valid until EndEpoch, which must only be called between them.
+ * New entries are refused once budget_bytes are in use.
+ *
+ * A hit needs a second, independently mixed hash (check) and the node
+ * count to match as well, so a wrong column is only returned if two
+ * different subtrees collide in 128 bits at once.
+ */
+class SubtreeCache {
+public:
+	/* Subtrees smaller than this are cheaper to recompute than to keep */
+	static const size_t kMinNodes = 5;
+
+	explicit SubtreeCache(size_t budget_bytes);
+
+	/* Rows [row_begin, row_begin + count) of the subtree, or null */
+	const double* Find(uint64_t hash, uint64_t check, size_t node_count,
+					   size_t row_begin, size_t count);
+	void Insert(uint64_t hash, uint64_t check, size_t node_count,
+				size_t row_begin, size_t count, const double *values);
+
+	/* Frees entries unused for the last two epochs; see above */
+	void EndEpoch();
+
+	/* Private Accessors */
+	size_t GetMemoryUsage();
+	size_t GetHitCount();
+	size_t GetLookupCount();
+private:
+	struct Key {
+		uint64_t hash;
+		size_t row_begin;
+		bool operator==(const Key &other) const;
+	};
+	struct KeyHash {
+		size_t operator()(const Key &key) const;
+	};
+	struct Entry {
+		uint64_t check; /* With node_count, guards against collisions */
+		size_t node_count;
+		size_t last_epoch;
+		std::vector<double> values;
+	};
+
+	/* Split by hash so threads rarely wait on the same lock */
+	struct Shard {
+		std::mutex mutex;
+		std::unordered_map<Key, Entry, KeyHash> entries;
+		size_t hits;
+		size_t lookups;
+	};
+	static const size_t kShardCount = 16;
+	static const size_t kEntryOverhead = 64; /* Map node and bookkeeping */
+
+	Shard& GetShard(uint64_t hash);
+
+	Shard shards_[kShardCount];
+	size_t budget_bytes_;
+	std::atomic<size_t> used_bytes_;
+	size_t epoch_; /* Only changes in EndEpoch */
+};
@@ -0,0 +1,120 @@
+/*
+* thread_pool.cpp
+* UIdaho CS-572: Evolutionary Computation
+* ThreadPool class - a fixed set of worker threads that share parallel
+* loops with the calling thread
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t thread_count, const NumaTopology *topology) {
+	if (thread_count == 0) {
+		thread_count = std::thread::hardware_concurrency();
+	}
+	if (thread_count == 0) {
+		thread_count = 1;
+	}
+	stopping_ = false;
+	job_ = nullptr;
+	job_count_ = 0;
+	job_generation_ = 0;
+	busy_workers_ = 0;
+	next_index_ = 0;
+
+	/* The calling thread is the last worker */
+	for (size_t i = 1; i < thread_count; ++i) {
+		size_t node = topology ? i % topology->GetNodeCount() : 0;
+		workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this,
+									   topology, node));
+	}
+}
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	job_ready_.notify_all();
+	for (auto &w : workers_) {
+		w.join();
+	}
+}
+void ThreadPool::ParallelFor(size_t count,
+							 const std::function<void(size_t)> &fn) {
+	if (count == 0) {
+		return;
+	}
+	if (workers_.empty() || count == 1) {
+		for (size_t i = 0; i < count; ++i) {
+			fn(i);
+		}
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		job_ = &fn;
+		job_count_ = count;
+		next_index_ = 0;
+		busy_workers_ = workers_.size();
+		++job_generation_;
+	}
+	job_ready_.notify_all();
+	RunJob();
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	job_done_.wait(lock, [this] { return busy_workers_ == 0; });
+	job_ = nullptr;
+}
+size_t ThreadPool::GetThreadCount() {
+	return workers_.size() + 1;
+}
+
+/* Private Helper Functions */
+void ThreadPool::WorkerLoop(const NumaTopology *topology, size_t node) {
+	if (topology) {
+		topology->PinThread(node);
+	}
+	size_t seen_generation = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			job_ready_.wait(lock, [this, seen_generation] {
+				return stopping_ || job_generation_ != seen_generation;
+			});
+			if (stopping_) {
+				return;
+			}
+			seen_generation = job_generation_;
+		}
+		RunJob();
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			--busy_workers_;
+		}
+		job_done_.notify_one();
+	}
+}
+void ThreadPool::RunJob() {
+	for (;;) {
+		size_t i = next_index_.fetch_add(1);
+		if (i >= job_count_) {
+			break;
+		}
+		(*job_)(i);
+	}
+}
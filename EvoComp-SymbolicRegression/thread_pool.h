@@ -0,0 +1,69 @@
+/*
+* thread_pool.h
+* UIdaho CS-572: Evolutionary Computation
+* Header for ThreadPool class - a fixed set of worker threads that share
+* parallel loops with the calling thread
+*
+* Copyright (C) 2015 Chris Waltrip <walt2178@vandals.uidaho.edu>
+*
+* This file is part of EC-SymbolicReg
+*
+* EC-SymbolicReg is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EC-SymbolicReg is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with EC-SymbolicReg.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "numa_topology.h"
+
+class ThreadPool {
+public:
+	/*
+	 * A thread_count of 0 uses every hardware thread.  With a topology,
+	 * worker i is pinned to node i modulo the node count, which must
+	 * outlive the pool; the calling thread is left alone.
+	 */
+	ThreadPool(size_t thread_count = 0,
+			   const NumaTopology *topology = nullptr);
+	~ThreadPool();
+
+	/*
+	 * Calls fn(i) for every i in [0, count), spread over the workers and
+	 * the calling thread, and returns once all of them have finished.
+	 * Indices are handed out one at a time, so uneven work balances out.
+	 */
+	void ParallelFor(size_t count, const std::function<void(size_t)> &fn);
+	size_t GetThreadCount();
+private:
+	void WorkerLoop(const NumaTopology *topology, size_t node);
+	void RunJob();
+
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	std::condition_variable job_ready_;
+	std::condition_variable job_done_;
+	bool stopping_;
+
+	/* Current job, only valid while busy_workers_ is non-zero */
+	const std::function<void(size_t)> *job_;
+	size_t job_count_;
+	size_t job_generation_;
+	size_t busy_workers_;
+	std::atomic<size_t> next_index_;
+};